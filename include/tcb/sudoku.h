@@ -75,6 +75,37 @@ SudokuGrid *sudoku_grid_scan(void);
  */
 SudokuGrid *sudoku_grid_fscan(FILE* file);
 
+/** Opaque type for reading many grids from one file */
+typedef struct SudokuReader SudokuReader;
+
+/**
+ * Creates a reader for the grids in a file stream.
+ * A reader reads from the file in large blocks, so it is much faster than
+ * calling sudoku_grid_fscan() repeatedly when there are many grids to read.
+ * Because it reads ahead, the file should not be used directly while the
+ * reader exists.
+ *
+ * Returns `NULL` if `file` is `NULL` or memory could not be allocated.
+ * You must free the returned reader with sudoku_reader_free().
+ */
+SudokuReader *sudoku_reader_new(FILE *file);
+
+/**
+ * Reads the next grid from a reader, exactly as sudoku_grid_fscan() would.
+ * Returns `NULL` once there are fewer than 81 valid characters left in the
+ * file.
+ *
+ * You must free the returned grid with sudoku_grid_free().
+ */
+SudokuGrid *sudoku_reader_next(SudokuReader *reader);
+
+/**
+ * Frees a reader created with sudoku_reader_new().
+ * If the file supports seeking, it is left positioned just after the last
+ * grid the reader returned. The file is not closed.
+ */
+void sudoku_reader_free(SudokuReader *reader);
+
 /**
  * Frees a grid created with sudoku_grid_parse() or sudoku_grid_solve()
  */
@@ -34,16 +34,38 @@ SOFTWARE.
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <iosfwd>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <string_view>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+#define TCB_SUDOKU_HAVE_COROUTINES
+#endif
 
 
 
 namespace tcb {
 namespace sudoku {
 
+class worker_pool;
+
+/// A grid packed into 41 bytes, at four bits per cell.
+/// Cell `n` is stored in the low four bits of byte `n / 2` if `n` is even, and
+/// in the high four bits if it is odd. Unknown cells are stored as 0, and
+/// known cells as their digit. The last four bits are always zero.
+/// @sa grid::pack(), grid::unpack()
+using packed_grid = std::array<std::uint8_t, 41>;
+
 /// A class representing a sudoku grid.
 /// A grid always contains exactly 81 elements, where each element is a character
 /// in the range `[1-9]`, or the character `.`. Grids are immutable once
@@ -80,6 +102,13 @@ public:
     /// be read (i.e. if the end-of-stream was reached).
     static auto parse(std::istream& istream) -> std::optional<grid>;
 
+    /// Unpacks a grid created with pack().
+    /// Will fail (returning `nullopt`) if any cell holds a value greater than 9.
+    static auto unpack(const packed_grid& packed) -> std::optional<grid>;
+
+    /// Returns the grid packed into 41 bytes
+    auto pack() const -> packed_grid;
+
     /// Default constructs an empty grid of 81 '.'s.
     grid() { cells_.fill('.'); cells_.back() = '\0'; }
 
@@ -189,20 +218,652 @@ inline void swap(grid& lhs, grid& rhs)
     lhs.swap(rhs);
 }
 
+/// A read-only view of a grid stored in someone else's buffer.
+/// A grid_view refers to 81 consecutive characters, each of which is `.` or
+/// a digit, where `0` means the same as `.`. Use grid_view::from() to check
+/// a buffer and create a view of it, without copying. The buffer must
+/// outlive the view. Every grid can also be viewed as a grid_view.
+class grid_view {
+public:
+    /// @cond
+    using value_type = char;
+    using size_type = std::size_t;
+    /// @endcond
+
+    /// Creates a view of the first 81 characters of `str`, if they are all
+    /// cells. Unlike grid::parse(), no other characters are allowed.
+    /// Returns `nullopt` if `str` doesn't start with 81 cells.
+    static auto from(std::string_view str) -> std::optional<grid_view>;
+
+    /// Creates a view of a grid
+    grid_view(const grid& g) noexcept : data_(g.data()) {}
+
+    /// Returns the cell at position `idx`, which is either `.` or a digit
+    /// from `1` to `9`
+    auto operator[](size_type idx) const -> char
+    {
+        return data_[idx] == '0' ? '.' : data_[idx];
+    }
+
+    /// Returns the size of the grid, i.e. 81
+    static constexpr auto size() -> size_type { return 81; }
+
+    /// Returns a pointer to the characters in the underlying buffer. Unlike
+    /// operator[], this may contain `0`s for unknown cells.
+    auto data() const -> const char* { return data_; }
+
+private:
+    explicit grid_view(const char* data) noexcept : data_(data) {}
+
+    const char* data_;
+};
+
+/// Writes a packed corpus: a file format for storing large numbers of grids
+/// in half the space of the usual one-per-line text files. A packed corpus
+/// starts with a 16-byte header, which is the 8 bytes of
+/// `packed_corpus_magic` followed by the number of grids as a 64-bit
+/// little-endian integer. Each grid then follows, as the 41 bytes of a
+/// packed_grid.
+///
+/// Check the state of the stream to find out whether writing succeeded.
+void write_packed_corpus(std::ostream& os, const std::vector<packed_grid>& grids);
+
+/// Reads a packed corpus written by write_packed_corpus().
+/// Will fail (returning `nullopt`) if the stream doesn't start with a packed
+/// corpus header, or ends before all the grids have been read.
+auto read_packed_corpus(std::istream& is) -> std::optional<std::vector<packed_grid>>;
+
+/// The first 8 bytes of a packed corpus.
+/// @sa write_packed_corpus()
+constexpr std::string_view packed_corpus_magic{"SUDOKU\x04\x01", 8};
+
+/// The number of characters written by format_to()
+constexpr std::size_t formatted_grid_size = 241;
+
+/// Writes the grid, drawn as a recognisable sudoku board, to the buffer
+/// starting at `out`, which must have room for `formatted_grid_size`
+/// characters. No null terminator is written. Never allocates.
+/// @returns A pointer just past the last character written
+auto format_to(char* out, const grid& grid_) -> char*;
+
 /// Pretty-prints a grid as a recognisable sudoku board.
+/// @sa format_to()
 std::ostream& operator<<(std::ostream& os, const grid& g);
 
+/// Checks that no digit appears more than once in any row, column or box of
+/// the given grid. Returns the positions (from 0 to 80, in order) of every
+/// cell whose digit also appears in another cell of the same row, column or
+/// box, or an empty vector if there are none.
+///
+/// A grid which passes this check may still have no solution, but solve()
+/// rejects any grid which fails it without doing any further work.
+auto validate(const grid& grid_) -> std::vector<int>;
+
+/// Checks the grid in the given view for duplicate digits, exactly as
+/// validate(const grid&).
+auto validate(grid_view grid_) -> std::vector<int>;
+
 /// Attempts to solve the given grid.
 /// If the solve algorithm fails or the supplied grid contains no solutions,
 /// returns `nullopt`. Otherwise returns the new, completed grid.
 auto solve(const grid& grid_) -> std::optional<grid>;
 
+/// Attempts to solve the grid in the given view, without copying it first.
+/// @sa solve(const grid&)
+auto solve(grid_view grid_) -> std::optional<grid>;
+
+/// The order in which the solver tries the possible digits for a cell
+enum class value_order {
+    ascending,  ///< Try 1 first, then 2, and so on
+    descending, ///< Try 9 first, then 8, and so on
+    random,     ///< Try the digits in a random order
+    least_constraining ///< Try first the digit which fewest unknown peers could be
+};
+
+/// The engine used to solve a grid
+enum class solver_backend {
+    /// Depth-first search with constraint propagation
+    search,
+    /// A built-in CDCL SAT solver, which learns from its mistakes. This is
+    /// slower on most puzzles, but much better at the very hardest ones.
+    sat
+};
+
+/// How much reasoning the solver does before each guess. Each level also
+/// includes everything from the levels before it. Higher levels mean fewer
+/// guesses, but more time spent on each one.
+enum class propagation_level {
+    /// Naked singles (cells with only one possible value) and hidden singles
+    /// (digits with only one possible place in a row, column or box)
+    singles,
+    /// Pointing and claiming: digits whose places in one unit all lie inside
+    /// another are eliminated from the rest of the other unit
+    locked_candidates,
+    /// Naked and hidden pairs and triples
+    subsets,
+    /// X-Wings
+    x_wing
+};
+
+/// How the solver chooses what to guess next
+enum class branching_rule {
+    /// Guess the value of the first cell with the fewest possible values
+    mrv,
+    /// Guess the value of a cell with the fewest possible values, preferring
+    /// the one with the most unknown peers
+    mrv_degree,
+    /// As mrv_degree, except that if some digit has fewer possible places in
+    /// a row, column or box than that cell has values, guess its place instead
+    units
+};
+
+/// How often the solver abandons its search and starts again from the top
+enum class restart_policy {
+    none,     ///< Never restart
+    luby,     ///< Restart after restart_base times 1,1,2,1,1,2,4,1,... guesses
+    geometric ///< Restart after restart_base guesses, growing by half each time
+};
+
+/// Options controlling how solve() goes about solving a grid
+struct solve_options {
+    /// The engine used to solve the grid. The SAT backend ignores all of
+    /// the options below which control the search, and may return a
+    /// different solution (if there is more than one) from the normal search.
+    /// For this backend, `solve_stats::guesses` counts decisions,
+    /// `solve_stats::backtracks` counts conflicts and `solve_stats::restarts`
+    /// counts restarts.
+    solver_backend backend = solver_backend::search;
+
+    /// How much reasoning the solver does before each guess
+    propagation_level propagation = propagation_level::singles;
+
+    /// If true, the solver keeps track of which earlier guesses caused each
+    /// deduction. When it runs out of values to try for a cell, it can then
+    /// jump straight back to the guess responsible rather than undoing one
+    /// guess at a time, and it remembers small combinations of guesses which
+    /// don't work so that it never tries them again. This helps on puzzles
+    /// designed to defeat ordinary backtracking.
+    ///
+    /// In this mode only singles are propagated, cells are chosen with
+    /// `branching_rule::mrv` and values are tried in ascending order, so
+    /// the `propagation`, `branching`, `values`, `random_ties` and
+    /// `restarts` options are ignored.
+    bool backjumping = false;
+
+    /// How the solver chooses what to guess next. If the library was built
+    /// with a fixed branching rule (using the `TCB_SUDOKU_BRANCHING` CMake
+    /// option), this is ignored.
+    branching_rule branching = branching_rule::mrv;
+
+    /// The order in which digits are tried when the solver needs to guess
+    value_order values = value_order::ascending;
+
+    /// If true, the solver chooses at random between the cells with the
+    /// fewest possibilities when it needs to guess, rather than always taking
+    /// the first one.
+    bool random_ties = false;
+
+    /// The seed for the random choices made by `value_order::random` and
+    /// `random_ties`. Solving the same grid with the same seed always makes
+    /// the same choices.
+    std::uint64_t seed = 0;
+
+    /// Whether the solver should periodically give up and start again.
+    /// Unlucky early guesses can make a deterministic search take a very
+    /// long time on some puzzles; with random choices, restarting gives
+    /// the solver another roll of the dice. The limits keep growing, so a
+    /// solution is still always found if there is one.
+    restart_policy restarts = restart_policy::none;
+
+    /// The number of guesses allowed before the first restart
+    std::uint64_t restart_base = 100;
+
+    /// If greater than zero, the search remembers (in a table of at most this
+    /// many entries) which positions it has already explored, and how many
+    /// solutions they had. Positions which led nowhere are never explored
+    /// again, and count_solutions() reuses earlier counts. The table lives in
+    /// the solver, so it carries over between restarts and between calls to
+    /// the same solver; this pays off when the same puzzle is solved or
+    /// counted repeatedly with small changes, as when generating puzzles.
+    /// Backjumping and the SAT backend don't use the table.
+    /// The table is allocated when a solver first uses it, and reallocated if
+    /// it is later asked for a table of a different size.
+    std::size_t transposition_table_size = 0;
+
+    /// If greater than zero, the first `parallel_depth` levels of the search
+    /// tree are split into separate pieces of work, which are explored
+    /// concurrently by the calling thread and the threads of `pool`. As soon
+    /// as one of them finds a solution, the others are cancelled.
+    ///
+    /// This uses more CPU time in total, but can greatly reduce the time
+    /// taken to solve hard puzzles. If the grid has more than one solution,
+    /// which one is returned is unspecified.
+    int parallel_depth = 0;
+
+    /// If not empty, each of these variants is run concurrently on the
+    /// calling thread and the threads of `pool`. The first answer any of
+    /// them comes up with is returned, and the others are cancelled. Since
+    /// different variants are lucky on different puzzles, this cuts down on
+    /// the occasional very slow solve.
+    ///
+    /// The `parallel_depth`, `pool` and `portfolio` members of the variants
+    /// themselves are ignored.
+    std::vector<solve_options> portfolio;
+
+    /// The pool used for parallel and portfolio search. If null, the default
+    /// pool is used.
+    worker_pool* pool = nullptr;
+};
+
+/// Returns a list of (at most) `size` solver variants which are suitable for
+/// use as a solve_options::portfolio.
+auto default_portfolio(int size) -> std::vector<solve_options>;
+
+/// Attempts to solve the given grid, using the given options.
+/// @sa solve(const grid&)
+auto solve(const grid& grid_, const solve_options& options) -> std::optional<grid>;
+
+/// Returns the number of solutions of the given grid, stopping once it has
+/// found `max_count` of them. For example, `count_solutions(g, 2) == 1` checks
+/// that a puzzle has a unique solution. The `parallel_depth`, `portfolio` and
+/// `pool` options are ignored, and the search backend is always used.
+auto count_solutions(const grid& grid_,
+                     std::uint64_t max_count = std::numeric_limits<std::uint64_t>::max(),
+                     const solve_options& options = {}) -> std::uint64_t;
+
+/// Statistics about a solve
+struct solve_stats {
+    /// The number of times the solver had to guess the value of a cell
+    std::uint64_t guesses = 0;
+    /// The number of times the solver ran out of values to try for a cell,
+    /// and so had to undo an earlier guess
+    std::uint64_t backtracks = 0;
+    /// The number of times the solver started again from the top
+    std::uint64_t restarts = 0;
+    /// The number of guesses which backjumping skipped over when undoing
+    /// earlier guesses
+    std::uint64_t backjumps = 0;
+    /// The number of positions which the transposition table allowed the
+    /// solver to skip
+    std::uint64_t table_hits = 0;
+};
+
+/// A reusable solver.
+/// All the memory the normal search needs is allocated when a solver is
+/// created, so with the default `backend`, calling solve() or
+/// count_solutions() never allocates. The exception is the transposition
+/// table, which is allocated by the first call which asks for one, and again
+/// whenever `transposition_table_size` changes. The SAT backend is set up the
+/// first time it is used, and grows its list of learnt clauses as it goes, so
+/// it can also allocate. A solver may not be used by more than one thread at
+/// a time. (The free function solve() uses a separate solver for each thread
+/// behind the scenes.)
+class solver {
+public:
+    /// Creates a new solver
+    solver();
+
+    /// @cond
+    solver(solver&&) noexcept;
+    solver& operator=(solver&&) noexcept;
+    ~solver();
+    /// @endcond
+
+    /// Attempts to solve the given grid, exactly as the free function solve()
+    auto solve(const grid& grid_) -> std::optional<grid>;
+
+    /// Attempts to solve the given grid, using the given options. A solver
+    /// always works on the calling thread, so the `parallel_depth`,
+    /// `portfolio` and `pool` options are ignored.
+    auto solve(const grid& grid_, const solve_options& options) -> std::optional<grid>;
+
+    /// Counts the solutions of the given grid, exactly as the free function
+    /// count_solutions(). If the options ask for a transposition table, it is
+    /// kept for the next call.
+    auto count_solutions(const grid& grid_,
+                         std::uint64_t max_count = std::numeric_limits<std::uint64_t>::max(),
+                         const solve_options& options = {}) -> std::uint64_t;
+
+    /// Returns statistics about the most recent call to solve() or
+    /// count_solutions()
+    auto stats() const -> solve_stats;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+/// Finds the solutions of a grid one at a time.
+/// The first solution returned is always the same as that returned by
+/// solve(). Use this if you want to know whether a puzzle has more than one
+/// solution, or to look at all of them.
+class solution_enumerator {
+public:
+    /// Prepares to find the solutions of the given grid
+    explicit solution_enumerator(const grid& grid_);
+
+    /// @cond
+    solution_enumerator(solution_enumerator&&) noexcept;
+    solution_enumerator& operator=(solution_enumerator&&) noexcept;
+    ~solution_enumerator();
+    /// @endcond
+
+    /// Returns the next solution, or `nullopt` if there are no more
+    auto next() -> std::optional<grid>;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+/// Attempts to solve each of the given grids.
+/// The results are the same as calling solve() on each grid in turn, but this
+/// is much faster for large numbers of easy puzzles. Constraint propagation is
+/// run on several puzzles at once using SIMD instructions where the CPU
+/// supports them, and only those puzzles which need a search are passed on
+/// to the normal solver.
+auto solve_batch(const std::vector<grid>& grids) -> std::vector<std::optional<grid>>;
+
+/// A NUMA node, and the CPUs which belong to it
+struct numa_node {
+    /// The node number, as used by the operating system
+    int id;
+    /// The (logical) CPUs on this node
+    std::vector<int> cpus;
+};
+
+/// Returns the NUMA topology of the machine.
+/// On Linux this is read from `/sys/devices/system/node`. Elsewhere, or if
+/// the topology can't be read, a single node containing every CPU is
+/// returned.
+auto numa_topology() -> std::vector<numa_node>;
+
+/// A pool of worker threads which can be used to solve puzzles in the
+/// background.
+/// Most users will not need to create one of these, as a shared pool is used
+/// by default.
+class worker_pool {
+public:
+    /// Creates a pool with the given number of threads. If `num_threads` is
+    /// zero, one thread is created for each hardware thread.
+    explicit worker_pool(unsigned num_threads = 0);
+
+    /// Creates a pool with one thread for each CPU in `cpus`, with each
+    /// thread pinned to its CPU.
+    /// Pinning is only supported on Linux, and is ignored elsewhere. Combined
+    /// with numa_topology(), this can be used to keep all of a pool's work
+    /// (and memory) on one NUMA node.
+    /// Throws `std::invalid_argument` if `cpus` is empty.
+    explicit worker_pool(const std::vector<int>& cpus);
+
+    /// Waits for all submitted work to finish, and then stops the threads.
+    ~worker_pool();
+
+    /// @cond
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+    /// @endcond
+
+    /// Returns the number of threads in the pool
+    auto size() const -> unsigned;
+
+    /// Arranges for `task` to be run on one of the pool's threads.
+    void post(std::function<void()> task);
+
+    /// Returns the pool which is used when none is specified
+    static auto default_pool() -> worker_pool&;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+/// Attempts to solve each of the given grids, using all the threads of
+/// `pool` as well as the calling thread.
+/// The results are the same as the single-threaded solve_batch(). Each
+/// worker copies the grids it is working on into its own buffers before
+/// solving them, so that if the pool's threads are pinned to CPUs, the
+/// memory they use stays local to their NUMA node.
+///
+/// This must not be called from one of the pool's own threads.
+auto solve_batch(const std::vector<grid>& grids, worker_pool& pool)
+    -> std::vector<std::optional<grid>>;
+
+/// A queue of callbacks from asynchronous solves.
+/// Callbacks passed to solve_async() are not run on the worker threads, but
+/// are instead queued up here until the owner of the queue calls poll() or
+/// wait(). This allows the results to be delivered on (say) an event loop
+/// thread, without any need for locking.
+class completion_queue {
+public:
+    completion_queue();
+    ~completion_queue();
+
+    /// @cond
+    completion_queue(const completion_queue&) = delete;
+    completion_queue& operator=(const completion_queue&) = delete;
+    /// @endcond
+
+    /// Runs the callbacks of all solves which have completed, on the calling
+    /// thread. Never blocks. Returns the number of callbacks run.
+    auto poll() -> std::size_t;
+
+    /// Blocks until at least one solve has completed, and then behaves as
+    /// poll().
+    auto wait() -> std::size_t;
+
+    /// @cond
+    void push(std::function<void()> completion);
+    /// @endcond
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+/// Starts solving the given grid on a worker thread.
+/// Returns a future which will contain the same result as solve() once the
+/// solve is complete.
+auto solve_async(const grid& grid_,
+                 worker_pool& pool = worker_pool::default_pool())
+    -> std::future<std::optional<grid>>;
+
+/// Starts solving the given grid on a worker thread.
+/// Once the solve is complete, `callback` will be called with the result the
+/// next time that `queue.poll()` or `queue.wait()` is called. The queue must
+/// outlive the solve.
+void solve_async(const grid& grid_, completion_queue& queue,
+                 std::function<void(std::optional<grid>)> callback,
+                 worker_pool& pool = worker_pool::default_pool());
+
 /// Returns a string (well, `string_view`) representation of the given grid
 inline auto to_string(const grid& grid) -> std::string_view
 {
     return {grid.data(), 81};
 }
 
+/// A solved grid, compressed to (usually) 10 or 11 bytes.
+/// Only the first `size` bytes of `bytes` are used; store those, and the
+/// size, however you like. The encoding is always at most 13 bytes long.
+/// @sa compress_solution(), decompress_solution()
+struct compact_solution {
+    /// The encoded grid
+    std::array<std::uint8_t, 13> bytes{};
+    /// The number of bytes used
+    std::size_t size = 0;
+};
+
+/// Compresses a solved grid.
+/// The cells are visited in order, and those whose digit is already forced by
+/// the row, column and box constraints of the cells before them are skipped.
+/// Each remaining cell is stored as its digit's position among those still
+/// possible, and all the positions are packed together into one number in
+/// mixed radix. This needs about 82 bits for a typical grid.
+///
+/// Returns `nullopt` if the grid is not a complete, valid solution.
+auto compress_solution(const grid& grid_) -> std::optional<compact_solution>;
+
+/// Decompresses a grid compressed with compress_solution().
+/// Returns `nullopt` if the data could not have come from compress_solution().
+auto decompress_solution(const compact_solution& compact) -> std::optional<grid>;
+
+#ifdef TCB_SUDOKU_HAVE_COROUTINES
+
+/// An awaitable which solves a grid on a worker thread.
+/// `co_await solve_task(g)` suspends the calling coroutine, and resumes it
+/// *on the worker thread* once the solve is complete, with the same result as
+/// solve(). Only available when compiling as C++20 (or later).
+class solve_task {
+public:
+    /// Prepares to solve `grid_` using a thread from `pool`
+    explicit solve_task(const grid& grid_,
+                        worker_pool& pool = worker_pool::default_pool())
+        : grid_(grid_), pool_(&pool)
+    {}
+
+    /// @cond
+    auto await_ready() const noexcept -> bool { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // This object lives in the awaiting coroutine's frame until it is
+        // resumed, so it's safe to hang on to `this`
+        pool_->post([this, handle] {
+            result_ = solve(grid_);
+            handle.resume();
+        });
+    }
+
+    auto await_resume() -> std::optional<grid> { return std::move(result_); }
+    /// @endcond
+
+private:
+    grid grid_;
+    worker_pool* pool_;
+    std::optional<grid> result_{};
+};
+
+/// A lazily-evaluated input range of grids, produced by a coroutine.
+/// @sa solutions()
+class grid_generator {
+public:
+    /// @cond
+    struct promise_type {
+        const grid* current = nullptr;
+        std::exception_ptr exception{};
+
+        auto get_return_object() -> grid_generator
+        {
+            return grid_generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+        auto final_suspend() noexcept -> std::suspend_always { return {}; }
+        auto yield_value(const grid& g) noexcept -> std::suspend_always
+        {
+            current = std::addressof(g);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = grid;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const grid*;
+        using reference = const grid&;
+
+        iterator() = default;
+        explicit iterator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        auto operator*() const -> reference { return *handle_.promise().current; }
+        auto operator->() const -> pointer { return handle_.promise().current; }
+
+        auto operator++() -> iterator&
+        {
+            handle_.resume();
+            if (handle_.done()) {
+                auto ex = std::exchange(handle_.promise().exception, nullptr);
+                handle_ = nullptr;
+                if (ex) {
+                    std::rethrow_exception(ex);
+                }
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend auto operator==(const iterator& lhs, const iterator& rhs) -> bool
+        {
+            return lhs.handle_ == rhs.handle_;
+        }
+        friend auto operator!=(const iterator& lhs, const iterator& rhs) -> bool
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_{};
+    };
+
+    grid_generator(grid_generator&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr))
+    {}
+
+    grid_generator& operator=(grid_generator&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~grid_generator()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+    /// @endcond
+
+    /// Starts the coroutine, and returns an iterator to the first grid.
+    /// May only be called once.
+    auto begin() -> iterator
+    {
+        auto it = iterator{handle_};
+        ++it;
+        return it;
+    }
+
+    /// Returns the end iterator
+    auto end() -> iterator { return {}; }
+
+private:
+    explicit grid_generator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/// Returns a generator which lazily yields the solutions of a grid.
+/// Each solution is only looked for once the previous one has been consumed,
+/// so it's cheap to stop early. Only available when compiling as C++20 (or
+/// later).
+/// @sa solution_enumerator
+inline auto solutions(grid grid_) -> grid_generator
+{
+    auto e = solution_enumerator{grid_};
+    while (auto soln = e.next()) {
+        co_yield *soln;
+    }
+}
+
+#endif // TCB_SUDOKU_HAVE_COROUTINES
+
 } // end namespace sudoku
 } // end namespace tcb
 
@@ -0,0 +1,102 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#include <tcb/sudoku.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace tcb {
+namespace sudoku {
+
+struct completion_queue::impl {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> completions;
+};
+
+completion_queue::completion_queue()
+    : impl_(std::make_unique<impl>())
+{}
+
+completion_queue::~completion_queue() = default;
+
+auto completion_queue::poll() -> std::size_t
+{
+    // Take everything that's ready in one go, so that callbacks are run
+    // without holding the lock (and can start new solves if they like)
+    std::deque<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock{impl_->mutex};
+        ready.swap(impl_->completions);
+    }
+
+    for (auto& f : ready) {
+        f();
+    }
+    return ready.size();
+}
+
+auto completion_queue::wait() -> std::size_t
+{
+    {
+        std::unique_lock<std::mutex> lock{impl_->mutex};
+        impl_->cv.wait(lock, [this] { return !impl_->completions.empty(); });
+    }
+    return poll();
+}
+
+void completion_queue::push(std::function<void()> completion)
+{
+    {
+        std::lock_guard<std::mutex> lock{impl_->mutex};
+        impl_->completions.push_back(std::move(completion));
+    }
+    impl_->cv.notify_all();
+}
+
+auto solve_async(const grid& grid_, worker_pool& pool)
+    -> std::future<std::optional<grid>>
+{
+    // std::function needs to be copyable, but packaged_task isn't
+    auto task = std::make_shared<std::packaged_task<std::optional<grid>()>>(
+        [grid_] { return solve(grid_); });
+    auto future = task->get_future();
+    pool.post([task] { (*task)(); });
+    return future;
+}
+
+void solve_async(const grid& grid_, completion_queue& queue,
+                 std::function<void(std::optional<grid>)> callback,
+                 worker_pool& pool)
+{
+    pool.post([grid_, &queue, callback = std::move(callback)] () mutable {
+        auto result = solve(grid_);
+        queue.push([result = std::move(result), callback = std::move(callback)] () mutable {
+            callback(std::move(result));
+        });
+    });
+}
+
+}
+}
@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#include <tcb/sudoku.hpp>
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+
+namespace tcb {
+namespace sudoku {
+
+namespace {
+
+auto select_kernel() -> detail::batch_kernel_t
+{
+#ifdef TCB_SUDOKU_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        return detail::solve_batch_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return detail::solve_batch_avx2;
+    }
+#endif
+    return detail::solve_batch_generic;
+}
+
+auto get_kernel() -> detail::batch_kernel_t
+{
+    static const auto kernel = select_kernel();
+    return kernel;
+}
+
+// Big enough to amortise the copying, small enough that a few hard puzzles
+// in one chunk don't leave the other threads idle for long
+constexpr std::size_t chunk_size = 1024;
+
+}
+
+void detail::solve_batch_generic(const grid* in, std::size_t count, std::optional<grid>* out)
+{
+    solve_lanes<generic_vec<8>>(in, count, out);
+}
+
+auto solve_batch(const std::vector<grid>& grids) -> std::vector<std::optional<grid>>
+{
+    auto results = std::vector<std::optional<grid>>(grids.size());
+    get_kernel()(grids.data(), grids.size(), results.data());
+    return results;
+}
+
+auto solve_batch(const std::vector<grid>& grids, worker_pool& pool)
+    -> std::vector<std::optional<grid>>
+{
+    const auto kernel = get_kernel();
+    auto results = std::vector<std::optional<grid>>(grids.size());
+    const auto num_chunks = (grids.size() + chunk_size - 1) / chunk_size;
+    std::atomic<std::size_t> next_chunk{0};
+
+    auto worker = [&] {
+        // These are allocated (and first touched) by the worker thread, so
+        // with the usual first-touch policy they live on the worker's NUMA
+        // node. They're reused for every chunk this worker handles.
+        std::vector<grid> in;
+        std::vector<std::optional<grid>> out;
+        in.reserve(chunk_size);
+        out.reserve(chunk_size);
+
+        for (auto chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+            const auto first = chunk * chunk_size;
+            const auto last = std::min(first + chunk_size, grids.size());
+            in.assign(grids.begin() + first, grids.begin() + last);
+            out.resize(in.size());
+            kernel(in.data(), in.size(), out.data());
+            std::move(out.begin(), out.end(), results.begin() + first);
+        }
+    };
+
+    if (num_chunks == 0) {
+        return results;
+    }
+
+    // The calling thread takes chunks too, so we finish however few of the
+    // pool's threads there are. The workers refer to our locals, so we wait
+    // for every one of them before passing on the first error.
+    const auto num_helpers = std::min<std::size_t>(pool.size(), num_chunks - 1);
+    std::vector<std::future<void>> done;
+    std::exception_ptr error;
+    try {
+        done.reserve(num_helpers);
+        for (std::size_t i = 0; i < num_helpers; i++) {
+            auto task = std::make_shared<std::packaged_task<void()>>(worker);
+            done.push_back(task->get_future());
+            pool.post([task] { (*task)(); });
+        }
+        worker();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& f : done) {
+        try {
+            f.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return results;
+}
+
+}
+}
@@ -0,0 +1,240 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#ifndef TCB_SUDOKU_BATCH_HPP
+#define TCB_SUDOKU_BATCH_HPP
+
+#include <tcb/sudoku.hpp>
+#include "solver.hpp"
+#include "tables.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace tcb {
+namespace sudoku {
+namespace detail {
+
+// Solves the `count` grids starting at `in`, writing the results to `out`.
+// There is one of these for each instruction set we know about; they're all
+// the same algorithm, but differ in the number of puzzles they handle at once.
+using batch_kernel_t = void (*)(const grid* in, std::size_t count, std::optional<grid>* out);
+
+void solve_batch_generic(const grid* in, std::size_t count, std::optional<grid>* out);
+void solve_batch_avx2(const grid* in, std::size_t count, std::optional<grid>* out);
+void solve_batch_avx512(const grid* in, std::size_t count, std::optional<grid>* out);
+
+// Everything below gets compiled once per instruction set (with different
+// compiler flags), so it needs internal linkage to keep the versions apart.
+namespace {
+
+// A portable "vector" of N 16-bit lanes. Each lane holds the candidates for
+// the same cell in a different puzzle. The loops are trivial enough that
+// compilers will happily turn them into SSE2/NEON instructions.
+template <std::size_t N>
+struct generic_vec {
+    static constexpr std::size_t lanes = N;
+
+    std::array<std::uint16_t, N> v;
+
+    static generic_vec load(const std::uint16_t* p)
+    {
+        generic_vec r;
+        for (std::size_t i = 0; i < N; i++) { r.v[i] = p[i]; }
+        return r;
+    }
+
+    void store(std::uint16_t* p) const
+    {
+        for (std::size_t i = 0; i < N; i++) { p[i] = v[i]; }
+    }
+
+    static generic_vec broadcast(std::uint16_t x)
+    {
+        generic_vec r;
+        r.v.fill(x);
+        return r;
+    }
+
+    template <typename Op>
+    friend generic_vec apply(generic_vec a, generic_vec b, Op op)
+    {
+        for (std::size_t i = 0; i < N; i++) {
+            a.v[i] = static_cast<std::uint16_t>(op(a.v[i], b.v[i]));
+        }
+        return a;
+    }
+
+    friend generic_vec operator&(generic_vec a, generic_vec b) { return apply(a, b, [](auto x, auto y) { return x & y; }); }
+    friend generic_vec operator|(generic_vec a, generic_vec b) { return apply(a, b, [](auto x, auto y) { return x | y; }); }
+    friend generic_vec operator^(generic_vec a, generic_vec b) { return apply(a, b, [](auto x, auto y) { return x ^ y; }); }
+    friend generic_vec operator-(generic_vec a, generic_vec b) { return apply(a, b, [](auto x, auto y) { return x - y; }); }
+
+    // Returns ~a & b
+    friend generic_vec andnot(generic_vec a, generic_vec b) { return apply(a, b, [](auto x, auto y) { return ~x & y; }); }
+
+    // Returns all ones in lanes which are zero, and zero elsewhere
+    friend generic_vec is_zero(generic_vec a) { return apply(a, a, [](auto x, auto) { return x == 0 ? 0xFFFF : 0; }); }
+
+    friend bool any(generic_vec a)
+    {
+        std::uint16_t r = 0;
+        for (auto x : a.v) { r |= x; }
+        return r != 0;
+    }
+};
+
+// The candidates for Vec::lanes puzzles, stored "sideways" so that the
+// candidates for each cell are contiguous
+template <typename Vec>
+struct lane_block {
+    alignas(64) std::uint16_t cells[81][Vec::lanes];
+};
+
+// Runs naked and hidden single propagation to a fixpoint in every lane at
+// once. Returns a vector which is non-zero in lanes that hit a contradiction.
+template <typename Vec>
+auto propagate_lanes(lane_block<Vec>& block) -> Vec
+{
+    const auto one = Vec::broadcast(1);
+    const auto all = Vec::broadcast(all_candidates);
+    auto bad = Vec::broadcast(0);
+    auto changed = Vec::broadcast(0);
+
+    do {
+        changed = Vec::broadcast(0);
+
+        for (const auto& unit : unit_indices) {
+            // First pass: which digits are known in this unit, and which
+            // digits appear as a candidate once, or more than once?
+            auto known = Vec::broadcast(0);
+            auto once = Vec::broadcast(0);
+            auto twice = Vec::broadcast(0);
+            for (int idx : unit) {
+                const auto x = Vec::load(block.cells[idx]);
+                const auto single = x & is_zero(x & (x - one));
+                bad = bad | (known & single);
+                known = known | single;
+                twice = twice | (once & x);
+                once = once | x;
+            }
+            // Every digit must be able to go somewhere
+            bad = bad | (once ^ all);
+            const auto unique = andnot(twice, once);
+
+            // Second pass: remove known digits from unknown cells, and fix
+            // any digit which only has one place to go
+            for (int idx : unit) {
+                const auto old = Vec::load(block.cells[idx]);
+                const auto fixed = is_zero(old & (old - one));
+                auto x = andnot(andnot(fixed, known), old);
+                const auto hidden = x & unique;
+                // Two digits which can only go in the same cell is no good
+                bad = bad | (hidden & (hidden - one));
+                const auto keep = is_zero(hidden);
+                x = (x & keep) | andnot(keep, hidden);
+                changed = changed | (x ^ old);
+                x.store(block.cells[idx]);
+            }
+        }
+    } while (any(changed));
+
+    for (const auto& cell : block.cells) {
+        bad = bad | is_zero(Vec::load(cell));
+    }
+
+    return bad;
+}
+
+inline int single_digit(std::uint16_t bits)
+{
+    int d = 1;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        ++d;
+    }
+    return d;
+}
+
+template <typename Vec>
+void solve_lanes(const grid* in, std::size_t count, std::optional<grid>* out)
+{
+    constexpr auto lanes = Vec::lanes;
+    const auto one = Vec::broadcast(1);
+    lane_block<Vec> block;
+
+    for (std::size_t first = 0; first < count; first += lanes) {
+        const auto n = count - first < lanes ? count - first : lanes;
+
+        // Spare lanes just get an empty grid, which doesn't need any work
+        for (std::size_t i = 0; i < 81; i++) {
+            for (std::size_t l = 0; l < lanes; l++) {
+                const char c = l < n ? in[first + l][i] : '.';
+                block.cells[i][l] = c == '.' ? all_candidates
+                                             : static_cast<std::uint16_t>(1u << (c - '1'));
+            }
+        }
+
+        const auto bad = propagate_lanes(block);
+
+        auto unsolved = Vec::broadcast(0);
+        for (const auto& cell : block.cells) {
+            const auto x = Vec::load(cell);
+            unsolved = unsolved | (x & (x - one));
+        }
+
+        std::uint16_t bad_lanes[lanes];
+        std::uint16_t unsolved_lanes[lanes];
+        bad.store(bad_lanes);
+        unsolved.store(unsolved_lanes);
+
+        for (std::size_t l = 0; l < n; l++) {
+            auto& result = out[first + l];
+            if (bad_lanes[l] != 0) {
+                result = std::nullopt;
+            } else if (unsolved_lanes[l] != 0) {
+                // Needs a search, so hand it off to the scalar solver
+                candidates_t candidates;
+                for (std::size_t i = 0; i < 81; i++) {
+                    candidates[i] = block.cells[i][l];
+                }
+                result = solve_candidates(candidates);
+            } else {
+                std::array<char, 81> chars;
+                for (std::size_t i = 0; i < 81; i++) {
+                    chars[i] = static_cast<char>('0' + single_digit(block.cells[i][l]));
+                }
+                result = grid::parse({chars.data(), chars.size()});
+            }
+        }
+    }
+}
+
+} // end anonymous namespace
+
+} // end namespace detail
+} // end namespace sudoku
+} // end namespace tcb
+
+#endif
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+// This file is compiled with -mavx2, and must only be called after checking
+// that the CPU supports it
+
+#include "batch.hpp"
+
+#include <immintrin.h>
+
+namespace tcb {
+namespace sudoku {
+namespace detail {
+
+namespace {
+
+struct avx2_vec {
+    static constexpr std::size_t lanes = 16;
+
+    __m256i v;
+
+    static avx2_vec load(const std::uint16_t* p)
+    {
+        return {_mm256_load_si256(reinterpret_cast<const __m256i*>(p))};
+    }
+
+    void store(std::uint16_t* p) const
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+
+    static avx2_vec broadcast(std::uint16_t x)
+    {
+        return {_mm256_set1_epi16(static_cast<short>(x))};
+    }
+
+    friend avx2_vec operator&(avx2_vec a, avx2_vec b) { return {_mm256_and_si256(a.v, b.v)}; }
+    friend avx2_vec operator|(avx2_vec a, avx2_vec b) { return {_mm256_or_si256(a.v, b.v)}; }
+    friend avx2_vec operator^(avx2_vec a, avx2_vec b) { return {_mm256_xor_si256(a.v, b.v)}; }
+    friend avx2_vec operator-(avx2_vec a, avx2_vec b) { return {_mm256_sub_epi16(a.v, b.v)}; }
+    friend avx2_vec andnot(avx2_vec a, avx2_vec b) { return {_mm256_andnot_si256(a.v, b.v)}; }
+
+    friend avx2_vec is_zero(avx2_vec a)
+    {
+        return {_mm256_cmpeq_epi16(a.v, _mm256_setzero_si256())};
+    }
+
+    friend bool any(avx2_vec a) { return !_mm256_testz_si256(a.v, a.v); }
+};
+
+}
+
+void solve_batch_avx2(const grid* in, std::size_t count, std::optional<grid>* out)
+{
+    solve_lanes<avx2_vec>(in, count, out);
+}
+
+}
+}
+}
@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+// This file is compiled with -mavx512f -mavx512bw, and must only be called
+// after checking that the CPU supports it
+
+#include "batch.hpp"
+
+#include <immintrin.h>
+
+namespace tcb {
+namespace sudoku {
+namespace detail {
+
+namespace {
+
+struct avx512_vec {
+    static constexpr std::size_t lanes = 32;
+
+    __m512i v;
+
+    static avx512_vec load(const std::uint16_t* p)
+    {
+        return {_mm512_load_si512(p)};
+    }
+
+    void store(std::uint16_t* p) const
+    {
+        _mm512_storeu_si512(p, v);
+    }
+
+    static avx512_vec broadcast(std::uint16_t x)
+    {
+        return {_mm512_set1_epi16(static_cast<short>(x))};
+    }
+
+    friend avx512_vec operator&(avx512_vec a, avx512_vec b) { return {_mm512_and_si512(a.v, b.v)}; }
+    friend avx512_vec operator|(avx512_vec a, avx512_vec b) { return {_mm512_or_si512(a.v, b.v)}; }
+    friend avx512_vec operator^(avx512_vec a, avx512_vec b) { return {_mm512_xor_si512(a.v, b.v)}; }
+    friend avx512_vec operator-(avx512_vec a, avx512_vec b) { return {_mm512_sub_epi16(a.v, b.v)}; }
+    // Not _mm512_andnot_si512(), which sets off -Wmaybe-uninitialized in GCC 12
+    friend avx512_vec andnot(avx512_vec a, avx512_vec b) { return {_mm512_ternarylogic_epi32(a.v, b.v, b.v, 0x0C)}; }
+
+    friend avx512_vec is_zero(avx512_vec a)
+    {
+        return {_mm512_movm_epi16(_mm512_testn_epi16_mask(a.v, a.v))};
+    }
+
+    friend bool any(avx512_vec a) { return _mm512_test_epi16_mask(a.v, a.v) != 0; }
+};
+
+}
+
+void solve_batch_avx512(const grid* in, std::size_t count, std::optional<grid>* out)
+{
+    solve_lanes<avx512_vec>(in, count, out);
+}
+
+}
+}
+}
@@ -23,9 +23,12 @@ SOFTWARE.
 #include <tcb/sudoku.h>
 #include <tcb/sudoku.hpp>
 
-#include <cstring>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
-#include <sstream>
+#include <new>
+#include <string>
 
 struct SudokuGrid {
     tcb::sudoku::grid grid;
@@ -54,38 +57,116 @@ SudokuGrid* sudoku_grid_scan()
     return nullptr;
 }
 
+namespace {
+
+auto is_cell(char c) -> bool
+{
+    return (c >= '0' && c <= '9') || (c == '.');
+}
+
+// Copies cells from [first, last) into `cells` until there are 81 of them,
+// returning a pointer just past the last character used
+auto scan_cells(const char* first, const char* last, std::string& cells) -> const char*
+{
+    for (; first != last && cells.size() < 81; ++first) {
+        if (is_cell(*first)) {
+            cells.push_back(*first);
+        }
+    }
+    return first;
+}
+
+auto make_grid(const std::string& cells) -> SudokuGrid*
+{
+    auto grid = tcb::sudoku::grid::parse(cells);
+    if (grid) {
+        return new (std::nothrow) SudokuGrid{std::move(*grid)};
+    }
+    return nullptr;
+}
+
+}
+
 SudokuGrid* sudoku_grid_fscan(FILE* file)
 {
     if (!file) {
         return nullptr;
     }
 
-    // Annoyingly, we need to do all the filtering here, to build up a string
-    // to give to grid::parse().
-    std::string str;
-    static const auto is_ok = [] (char c) {
-        return (c >= '0' && c <= '9') || (c == '.');
-    };
+    // Every cell takes at least one character, so if we never read more
+    // characters than we have cells left to fill, we can read in blocks
+    // without going past the end of the grid
+    std::string cells;
+    char block[81];
+    while (cells.size() < 81) {
+        const auto wanted = 81 - cells.size();
+        const auto n = std::fread(block, sizeof(char), wanted, file);
+        scan_cells(block, block + n, cells);
+        if (n < wanted) {
+            break;
+        }
+    }
 
+    if (cells.size() < 81) {
+        return nullptr;
+    }
+    return make_grid(cells);
+}
 
-    while (str.size() < 81) {
-        char c;
-        if (std::fread(&c, sizeof(char), 1, file) != 1) {
-            return nullptr;
+struct SudokuReader {
+    FILE* file;
+    std::array<char, 65536> buffer;
+    const char* pos = buffer.data();
+    const char* end = buffer.data();
+    std::string cells{};
+};
+
+SudokuReader* sudoku_reader_new(FILE* file)
+{
+    if (!file) {
+        return nullptr;
+    }
+    auto* reader = new (std::nothrow) SudokuReader{file, {}};
+    if (reader) {
+        reader->cells.reserve(81);
+    }
+    return reader;
+}
+
+SudokuGrid* sudoku_reader_next(SudokuReader* reader)
+{
+    if (!reader) {
+        return nullptr;
+    }
+
+    reader->cells.clear();
+    while (true) {
+        reader->pos = scan_cells(reader->pos, reader->end, reader->cells);
+        if (reader->cells.size() == 81) {
+            return make_grid(reader->cells);
         }
 
-        if (!is_ok(c)) {
-            continue;
+        const auto n = std::fread(reader->buffer.data(), sizeof(char),
+                                  reader->buffer.size(), reader->file);
+        reader->pos = reader->buffer.data();
+        reader->end = reader->pos + n;
+        if (n == 0) {
+            return nullptr;
         }
+    }
+}
 
-        str.push_back(c);
+void sudoku_reader_free(SudokuReader* reader)
+{
+    if (!reader) {
+        return;
     }
 
-    auto grid = tcb::sudoku::grid::parse(str);
-    if (grid) {
-        return new (std::nothrow) SudokuGrid{std::move(*grid)};
+    // Give back whatever we read ahead, if the file lets us
+    if (reader->pos != reader->end) {
+        std::fseek(reader->file, -static_cast<long>(reader->end - reader->pos), SEEK_CUR);
     }
-    return nullptr;
+    delete reader;
 }
 
 void sudoku_grid_free(SudokuGrid* grid)
@@ -95,11 +176,7 @@ void sudoku_grid_free(SudokuGrid* grid)
 
 void sudoku_grid_pretty_print(const SudokuGrid* grid)
 {
-    if (!grid) {
-        return;
-    }
-
-    std::cout << grid->grid << std::endl;
+    sudoku_grid_pretty_fprint(stdout, grid);
 }
 
 void sudoku_grid_pretty_fprint(FILE* stream, const SudokuGrid* grid)
@@ -108,11 +185,9 @@ void sudoku_grid_pretty_fprint(FILE* stream, const SudokuGrid* grid)
         return;
     }
 
-    // This is a bit ugly, but oh well
-    std::stringstream s;
-    s << grid->grid;
-
-    std::fprintf(stream, "%s\n", s.str().c_str());
+    std::array<char, tcb::sudoku::formatted_grid_size + 1> buffer;
+    *tcb::sudoku::format_to(buffer.data(), grid->grid) = '\n';
+    std::fwrite(buffer.data(), sizeof(char), buffer.size(), stream);
 }
 
 const char* sudoku_grid_to_string(const SudokuGrid* grid)
@@ -129,10 +204,11 @@ char* sudoku_grid_to_formatted_string(const SudokuGrid* grid)
         return nullptr;
     }
 
-    std::stringstream ss;
-    ss << grid->grid;
-
-    return strdup(ss.str().c_str());
+    auto* str = static_cast<char*>(std::malloc(tcb::sudoku::formatted_grid_size + 1));
+    if (str) {
+        *tcb::sudoku::format_to(str, grid->grid) = '\0';
+    }
+    return str;
 }
 
 SudokuGrid* sudoku_solve(const SudokuGrid* grid)
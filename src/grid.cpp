@@ -23,27 +23,98 @@ SOFTWARE.
 #include <tcb/sudoku.hpp>
 
 #include <range/v3/algorithm/copy.hpp>
-#include <range/v3/iterator/stream_iterators.hpp>
 #include <range/v3/view/all.hpp>
-#include <range/v3/view/common.hpp>
-#include <range/v3/view/chunk.hpp>
 #include <range/v3/view/filter.hpp>
-#include <range/v3/view/intersperse.hpp>
-#include <range/v3/view/istream.hpp>
-#include <range/v3/view/join.hpp>
 #include <range/v3/view/replace.hpp>
 #include <range/v3/view/take.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TCB_SUDOKU_HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace rng = ranges;
 
 namespace tcb {
 namespace sudoku {
 
+namespace {
+
+auto is_cell(char c) -> bool
+{
+    return c == '.' || (c >= '0' && c <= '9');
+}
+
+// Returns true if the first 81 characters of `in` are all cells
+auto all_cells(const char* in) -> bool
+{
+#ifdef TCB_SUDOKU_HAVE_SSE2
+    // Check 16 characters at a time. Characters are signed here, so anything
+    // above 0x7f compares less than '0' and is rejected.
+    const auto dot = _mm_set1_epi8('.');
+    const auto below_zero = _mm_set1_epi8('0' - 1);
+    const auto above_nine = _mm_set1_epi8('9' + 1);
+    for (int i = 0; i < 80; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const auto is_digit = _mm_and_si128(_mm_cmpgt_epi8(v, below_zero),
+                                            _mm_cmplt_epi8(v, above_nine));
+        const auto ok = _mm_or_si128(_mm_cmpeq_epi8(v, dot), is_digit);
+        if (_mm_movemask_epi8(ok) != 0xffff) {
+            return false;
+        }
+    }
+    return is_cell(in[80]);
+#else
+    return std::all_of(in, in + 81, is_cell);
+#endif
+}
+
+// Copies 81 cells from `in` to `out`, replacing '0' with '.'
+void copy_cells(const char* in, char* out)
+{
+#ifdef TCB_SUDOKU_HAVE_SSE2
+    const auto dot = _mm_set1_epi8('.');
+    const auto zero = _mm_set1_epi8('0');
+    for (int i = 0; i < 80; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const auto is_zero = _mm_cmpeq_epi8(v, zero);
+        const auto cells = _mm_or_si128(_mm_andnot_si128(is_zero, v),
+                                        _mm_and_si128(is_zero, dot));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), cells);
+    }
+    out[80] = in[80] == '0' ? '.' : in[80];
+#else
+    std::replace_copy(in, in + 81, out, '0', '.');
+#endif
+}
+
+}
+
+auto grid_view::from(std::string_view str) -> std::optional<grid_view>
+{
+    if (str.size() >= 81 && all_cells(str.data())) {
+        return grid_view{str.data()};
+    }
+    return std::nullopt;
+}
+
 auto grid::parse(std::string_view str) -> std::optional<grid>
 {
+    // If the first 81 characters are all cells, they're exactly what the
+    // general path below would take
+    if (str.size() >= 81 && all_cells(str.data())) {
+        auto g = grid{};
+        copy_cells(str.data(), g.cells_.data());
+        return g;
+    }
+
     auto view = rng::views::all(str)
-            | rng::views::filter([](char c) { return c == '.' || (c >= '0' && c <= '9'); })
+            | rng::views::filter(is_cell)
             | rng::views::replace('0', '.')
             | rng::views::take(81);
 
@@ -58,61 +129,386 @@ auto grid::parse(std::string_view str) -> std::optional<grid>
 
 auto grid::parse(std::istream& istream) -> std::optional<grid>
 {
-    // Annoyingly in this case, but probably with good reason,
-    // rng::view::filter caches the next value -- which means that in the
-    // case of input iterators, it eats up the next token. There may be a way
-    // around this but I can't think of one right now, so we'll do things the
-    // longwinded way instead
+    // Rather than extracting one character at a time, we read blocks
+    // straight from the stream buffer. Each cell takes at least one
+    // character, so by never asking for more characters than we still have
+    // cells to fill, we can't read past the 81st cell.
+    const std::istream::sentry sentry{istream, true};
+    if (!sentry) {
+        return std::nullopt;
+    }
+
+    auto* buf = istream.rdbuf();
     auto count = 0;
     auto g = grid{};
-    auto range = rng::istream_range<char>{istream}
-            | rng::views::replace('0', '.')
-            | rng::views::common;
-
-    for (char c : range) {
-        if (c != '.' && (c < '1' || c > '9')) {
-            continue;
+    std::array<char, 81> block;
+    while (count < 81) {
+        const std::streamsize wanted = 81 - count;
+        const auto n = buf->sgetn(block.data(), wanted);
+        for (std::streamsize i = 0; i < n; i++) {
+            const char c = block[i];
+            if (is_cell(c)) {
+                g.cells_[count++] = c == '0' ? '.' : c;
+            }
         }
-
-        g.cells_[count] = c;
-
-        if (++count == 81) {
+        if (n < wanted) {
+            // End of file
             break;
         }
     }
 
     if (count < 81) {
+        istream.setstate(std::ios_base::eofbit | std::ios_base::failbit);
         return std::nullopt;
     }
 
     return g;
 }
 
+auto grid::pack() const -> packed_grid
+{
+    packed_grid packed;
+#ifdef TCB_SUDOKU_HAVE_SSE2
+    // '.' is below '0', so a saturating subtraction maps it to zero. Then
+    // each pair of cells is combined within a 16-bit lane, and the lanes
+    // narrowed back down to bytes.
+    const auto zero = _mm_set1_epi8('0');
+    const auto low_byte = _mm_set1_epi16(0x00ff);
+    for (int i = 0; i < 80; i += 16) {
+        const auto v = _mm_subs_epu8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells_.data() + i)), zero);
+        const auto pairs = _mm_or_si128(_mm_and_si128(v, low_byte),
+                                        _mm_slli_epi16(_mm_srli_epi16(v, 8), 4));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(packed.data() + i / 2),
+                         _mm_packus_epi16(pairs, pairs));
+    }
+#else
+    for (int i = 0; i < 80; i += 2) {
+        const auto lo = cells_[i] == '.' ? 0 : cells_[i] - '0';
+        const auto hi = cells_[i + 1] == '.' ? 0 : cells_[i + 1] - '0';
+        packed[i / 2] = static_cast<std::uint8_t>(lo | (hi << 4));
+    }
+#endif
+    packed[40] = static_cast<std::uint8_t>(cells_[80] == '.' ? 0 : cells_[80] - '0');
+    return packed;
+}
+
+auto grid::unpack(const packed_grid& packed) -> std::optional<grid>
+{
+    auto g = grid{};
+#ifdef TCB_SUDOKU_HAVE_SSE2
+    // Split each byte into its two nibbles, interleave them, and then turn
+    // zeros into dots and everything else into digits
+    const auto nibble = _mm_set1_epi8(0x0f);
+    const auto nine = _mm_set1_epi8(9);
+    const auto zero = _mm_set1_epi8('0');
+    const auto dot = _mm_set1_epi8('.');
+    for (int i = 0; i < 80; i += 16) {
+        const auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(packed.data() + i / 2));
+        const auto lo = _mm_and_si128(bytes, nibble);
+        const auto hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        const auto v = _mm_unpacklo_epi8(lo, hi);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(v, nine)) != 0) {
+            return std::nullopt;
+        }
+        const auto unknown = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+        const auto cells = _mm_or_si128(_mm_andnot_si128(unknown, _mm_add_epi8(v, zero)),
+                                        _mm_and_si128(unknown, dot));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(g.cells_.data() + i), cells);
+    }
+#else
+    for (int i = 0; i < 80; i++) {
+        const int v = (packed[i / 2] >> (i % 2 * 4)) & 0x0f;
+        if (v > 9) {
+            return std::nullopt;
+        }
+        g.cells_[i] = v == 0 ? '.' : static_cast<char>('0' + v);
+    }
+#endif
+    if (packed[40] > 9) {
+        return std::nullopt;
+    }
+    g.cells_[80] = packed[40] == 0 ? '.' : static_cast<char>('0' + packed[40]);
+    return g;
+}
+
+// The vector's contents are read and written in one go, so there mustn't be
+// any padding
+static_assert(sizeof(packed_grid) == 41, "packed_grid must not have padding");
+
+void write_packed_corpus(std::ostream& os, const std::vector<packed_grid>& grids)
+{
+    std::array<char, 16> header;
+    rng::copy(packed_corpus_magic, header.begin());
+    std::uint64_t count = grids.size();
+    for (int i = 8; i < 16; i++, count >>= 8) {
+        header[i] = static_cast<char>(count & 0xff);
+    }
+    os.write(header.data(), header.size());
+    os.write(reinterpret_cast<const char*>(grids.data()),
+             static_cast<std::streamsize>(grids.size() * sizeof(packed_grid)));
+}
+
+auto read_packed_corpus(std::istream& is) -> std::optional<std::vector<packed_grid>>
+{
+    std::array<char, 16> header;
+    if (!is.read(header.data(), header.size()) ||
+        std::string_view(header.data(), 8) != packed_corpus_magic) {
+        return std::nullopt;
+    }
+    std::uint64_t count = 0;
+    for (int i = 15; i >= 8; i--) {
+        count = (count << 8) | static_cast<unsigned char>(header[i]);
+    }
+
+    // Don't trust the count enough to allocate it all up front
+    std::vector<packed_grid> grids;
+    constexpr std::uint64_t block = 65536;
+    while (grids.size() < count) {
+        const auto n = std::min(count - grids.size(), block);
+        const auto old_size = grids.size();
+        grids.resize(old_size + n);
+        if (!is.read(reinterpret_cast<char*>(grids.data() + old_size),
+                     static_cast<std::streamsize>(n * sizeof(packed_grid)))) {
+            return std::nullopt;
+        }
+    }
+    return grids;
+}
+
+namespace {
+
+// An unsigned integer big enough to hold a compressed solution, as 32-bit
+// limbs (least significant first) so that products fit in 64 bits
+struct compact_number {
+    std::array<std::uint32_t, 4> limbs{};
+
+    void multiply_add(std::uint32_t m, std::uint32_t a)
+    {
+        std::uint64_t carry = a;
+        for (auto& limb : limbs) {
+            const auto x = std::uint64_t{limb} * m + carry;
+            limb = static_cast<std::uint32_t>(x);
+            carry = x >> 32;
+        }
+    }
+
+    // Divides by D, returning the remainder. With D known at compile time,
+    // the divisions become multiplications.
+    template <std::uint32_t D>
+    auto divide() -> std::uint32_t
+    {
+        // Most of the time the number fits in 64 bits, and one division will do
+        if ((limbs[2] | limbs[3]) == 0) {
+            const auto x = (std::uint64_t{limbs[1]} << 32) | limbs[0];
+            limbs[0] = static_cast<std::uint32_t>(x / D);
+            limbs[1] = static_cast<std::uint32_t>((x / D) >> 32);
+            return static_cast<std::uint32_t>(x % D);
+        }
+
+        std::uint64_t rem = 0;
+        for (auto i = limbs.size(); i-- > 0; ) {
+            const auto x = (rem << 32) | limbs[i];
+            limbs[i] = static_cast<std::uint32_t>(x / D);
+            rem = x % D;
+        }
+        return static_cast<std::uint32_t>(rem);
+    }
+
+    auto divide(std::uint32_t d) -> std::uint32_t
+    {
+        switch (d) {
+        case 2: return divide<2>();
+        case 3: return divide<3>();
+        case 4: return divide<4>();
+        case 5: return divide<5>();
+        case 6: return divide<6>();
+        case 7: return divide<7>();
+        case 8: return divide<8>();
+        default: return divide<9>();
+        }
+    }
+
+    auto is_zero() const -> bool
+    {
+        return (limbs[0] | limbs[1] | limbs[2] | limbs[3]) == 0;
+    }
+};
+
+// The digits which are still possible for each cell, given the digits placed
+// in the cells before it
+struct compact_masks {
+    std::array<std::uint16_t, 9> rows{};
+    std::array<std::uint16_t, 9> columns{};
+    std::array<std::uint16_t, 9> boxes{};
+
+    auto candidates(int row, int col) const -> std::uint16_t
+    {
+        return 0x1ff & ~(rows[row] | columns[col] | boxes[row / 3 * 3 + col / 3]);
+    }
+
+    void place(int row, int col, std::uint16_t bit)
+    {
+        rows[row] |= bit;
+        columns[col] |= bit;
+        boxes[row / 3 * 3 + col / 3] |= bit;
+    }
+};
+
+// The number of bits set in each 9-bit mask. A table lookup beats both a
+// loop and (without -mpopcnt) the compiler's popcount builtin.
+constexpr auto popcount_table = [] {
+    std::array<std::uint8_t, 512> table{};
+    for (int i = 1; i < 512; i++) {
+        table[i] = static_cast<std::uint8_t>(table[i / 2] + i % 2);
+    }
+    return table;
+}();
+
+auto popcount(std::uint16_t bits) -> std::uint32_t
+{
+    return popcount_table[bits & 0x1ff];
+}
+
+}
+
+auto compress_solution(const grid& g) -> std::optional<compact_solution>
+{
+    // The first cell ends up as the least significant digit, so that the
+    // decoder can peel them off in order. Since we only know each cell's
+    // radix as we go, we build the number from the last cell backwards,
+    // having recorded the positions and radices on the way forward.
+    std::array<std::uint8_t, 81> positions;
+    std::array<std::uint8_t, 81> radices;
+    compact_masks masks;
+    for (int i = 0; i < 81; i++) {
+        if (g[i] == '.') {
+            return std::nullopt;
+        }
+        const auto bit = static_cast<std::uint16_t>(1u << (g[i] - '1'));
+        const auto candidates = masks.candidates(i / 9, i % 9);
+        if ((candidates & bit) == 0) {
+            return std::nullopt;
+        }
+        positions[i] = static_cast<std::uint8_t>(popcount(candidates & (bit - 1)));
+        radices[i] = static_cast<std::uint8_t>(popcount(candidates));
+        masks.place(i / 9, i % 9, bit);
+    }
+
+    // Multiplying the whole number by each radix in turn would be slow, so
+    // we combine as many as will fit in 32 bits and apply them all at once
+    compact_number n;
+    std::uint64_t m = 1;
+    std::uint64_t a = 0;
+    for (int i = 81; i-- > 0; ) {
+        if (m * radices[i] > 0xffffffff) {
+            n.multiply_add(static_cast<std::uint32_t>(m), static_cast<std::uint32_t>(a));
+            m = 1;
+            a = 0;
+        }
+        m *= radices[i];
+        a = a * radices[i] + positions[i];
+    }
+    n.multiply_add(static_cast<std::uint32_t>(m), static_cast<std::uint32_t>(a));
+
+    compact_solution compact;
+    for (std::size_t i = 0; i < compact.bytes.size(); i++) {
+        compact.bytes[i] = static_cast<std::uint8_t>(n.limbs[i / 4] >> (i % 4 * 8));
+        if (compact.bytes[i] != 0) {
+            compact.size = i + 1;
+        }
+    }
+    return compact;
+}
+
+auto decompress_solution(const compact_solution& compact) -> std::optional<grid>
+{
+    if (compact.size > compact.bytes.size()) {
+        return std::nullopt;
+    }
+    compact_number n;
+    for (std::size_t i = 0; i < compact.size; i++) {
+        n.limbs[i / 4] |= std::uint32_t{compact.bytes[i]} << (i % 4 * 8);
+    }
+
+    std::array<char, 81> cells;
+    compact_masks masks;
+    for (int i = 0; i < 81; i++) {
+        auto candidates = masks.candidates(i / 9, i % 9);
+        const auto radix = popcount(candidates);
+        if (radix == 0) {
+            return std::nullopt;
+        }
+        // Skip past the first `position` possible digits
+        for (auto position = radix > 1 ? n.divide(radix) : 0; position > 0; position--) {
+            candidates &= candidates - 1;
+        }
+        const auto bit = static_cast<std::uint16_t>(candidates & -candidates);
+        masks.place(i / 9, i % 9, bit);
+        cells[i] = static_cast<char>('1' + popcount(static_cast<std::uint16_t>(bit - 1)));
+    }
+
+    // Anything left over means this wasn't a real encoding
+    if (!n.is_zero()) {
+        return std::nullopt;
+    }
+    return grid::parse({cells.data(), cells.size()});
+}
+
+namespace {
+
+// The pretty-printed board, with a space wherever a cell goes, and where in
+// it each cell goes
+struct board_template {
+    std::array<char, formatted_grid_size> chars{};
+    std::array<std::uint8_t, 81> offsets{};
+};
+
+constexpr auto make_board_template()
+{
+    board_template board;
+    std::size_t pos = 0;
+    for (int row = 0; row < 9; row++) {
+        if (row == 3 || row == 6) {
+            for (char c : std::string_view("------+-------+------\n")) {
+                board.chars[pos++] = c;
+            }
+        }
+        for (int col = 0; col < 9; col++) {
+            board.offsets[row * 9 + col] = static_cast<std::uint8_t>(pos);
+            board.chars[pos++] = ' ';
+            if (col == 2 || col == 5) {
+                board.chars[pos++] = ' ';
+                board.chars[pos++] = '|';
+                board.chars[pos++] = ' ';
+            } else if (col < 8) {
+                board.chars[pos++] = ' ';
+            } else if (row < 8) {
+                board.chars[pos++] = '\n';
+            }
+        }
+    }
+    return board;
+}
+
+constexpr auto board = make_board_template();
+
+}
+
+auto format_to(char* out, const grid& g) -> char*
+{
+    std::memcpy(out, board.chars.data(), board.chars.size());
+    for (int i = 0; i < 81; i++) {
+        out[board.offsets[i]] = g[i];
+    }
+    return out + board.chars.size();
+}
+
 auto operator<<(std::ostream& os, const grid& g) -> std::ostream&
 {
-    // And now for some fun. What we'd like to do is this:
-    //   * after every 9th element, insert a '\n'
-    //   * for every 3rd and 6th (but not 9th) element, insert a '|'
-    //   * after cells 27 and 54, insert "------+------+------\n"
-    //   * after every element not mentioned, insert a ' '.
-    //
-    // I'm fully aware that this is a silly way to do it.
-    auto range = rng::views::all(g)
-            | rng::views::chunk(27)
-            | rng::views::transform([] (auto&& third) {
-                return rng::views::all(third)
-                    | rng::views::chunk(9)
-                    | rng::views::transform([](auto&& row) {
-                        return rng::views::all(row)
-                            | rng::views::chunk(3)
-                            | rng::views::join('|')
-                            | rng::views::intersperse(' '); })
-                    | rng::views::join('\n'); })
-            | rng::views::join(std::string_view("\n------+-------+------\n"));
-
-    rng::copy(range, rng::ostream_iterator<>(os));
-
-    return os;
+    std::array<char, formatted_grid_size> buffer;
+    format_to(buffer.data(), g);
+    return os.write(buffer.data(), buffer.size());
 }
 
 }
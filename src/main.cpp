@@ -22,11 +22,31 @@ SOFTWARE.
 
 #include <tcb/sudoku.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
 #include <iterator>
 #include <fstream>
+#include <future>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TCB_SUDOKU_HAVE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 struct timer {
     using clock_type = std::chrono::high_resolution_clock;
@@ -43,12 +63,28 @@ private:
     clock_type::time_point start_ = clock_type::now();
 };
 
-auto solve_one(const tcb::sudoku::grid& grid, bool interactive)
+// Totals of the solver's statistics over all the puzzles we've solved. These
+// are only available when we're not using a portfolio.
+tcb::sudoku::solve_stats total_stats{};
+
+auto solve_one(const tcb::sudoku::grid& grid, const tcb::sudoku::solve_options& options,
+               bool interactive)
 {
+    static tcb::sudoku::solver solver{};
+
     timer t{};
-    auto solution = tcb::sudoku::solve(grid);
+    auto solution = options.portfolio.empty() ? solver.solve(grid, options)
+                                              : tcb::sudoku::solve(grid, options);
     auto e = t.elapsed();
 
+    if (options.portfolio.empty()) {
+        const auto stats = solver.stats();
+        total_stats.guesses += stats.guesses;
+        total_stats.backtracks += stats.backtracks;
+        total_stats.restarts += stats.restarts;
+        total_stats.backjumps += stats.backjumps;
+    }
+
     if (interactive) {
         std::cout << grid << "\n\n";
 
@@ -61,38 +97,522 @@ auto solve_one(const tcb::sudoku::grid& grid, bool interactive)
         std::cout << e.count() / 1000.00 << "ms elapsed\n";
     }
 
-    return e;
+    return std::make_pair(e, std::move(solution));
+}
+
+// Collects output in a large buffer, and hands it to the operating system in
+// big blocks. This avoids both iostreams and stdio, which add noticeable
+// overhead per grid when we're printing millions of them.
+class output_buffer {
+public:
+    explicit output_buffer(int fd) : fd_(fd) { buffer_.reserve(capacity); }
+
+    output_buffer(const output_buffer&) = delete;
+    output_buffer& operator=(const output_buffer&) = delete;
+
+    ~output_buffer() { flush(); }
+
+    void append(std::string_view str)
+    {
+        if (buffer_.size() + str.size() <= capacity) {
+            buffer_.insert(buffer_.end(), str.begin(), str.end());
+        } else {
+            // Write out what we have and the new data together
+            write_all({buffer_.data(), buffer_.size()}, str);
+            buffer_.clear();
+        }
+    }
+
+    // Returns space for n characters at the end of the buffer, which the
+    // caller must fill (n must be no more than the capacity)
+    auto extend(std::size_t n) -> char*
+    {
+        if (buffer_.size() + n > capacity) {
+            flush();
+        }
+        buffer_.resize(buffer_.size() + n);
+        return buffer_.data() + buffer_.size() - n;
+    }
+
+    void flush()
+    {
+        write_all({buffer_.data(), buffer_.size()}, {});
+        buffer_.clear();
+    }
+
+    // Returns the errno of the first write which failed, or zero if all of
+    // them succeeded. Anything appended after a failure is thrown away.
+    auto error() const -> int { return error_; }
+
+private:
+    static constexpr std::size_t capacity = 1 << 20;
+
+    void write_all(std::string_view first, std::string_view second)
+    {
+        if (error_ != 0) {
+            return;
+        }
+#ifdef TCB_SUDOKU_HAVE_POSIX
+        iovec iov[2] = {{const_cast<char*>(first.data()), first.size()},
+                        {const_cast<char*>(second.data()), second.size()}};
+        int n = 2;
+        iovec* next = iov;
+        while (n > 0) {
+            const auto written = ::writev(fd_, next, n);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error_ = errno;
+                return;
+            }
+            // Skip past whatever was written, which may end part-way through
+            // one of the blocks
+            auto left = static_cast<std::size_t>(written);
+            while (n > 0 && left >= next->iov_len) {
+                left -= next->iov_len;
+                ++next;
+                --n;
+            }
+            if (n > 0) {
+                next->iov_base = static_cast<char*>(next->iov_base) + left;
+                next->iov_len -= left;
+            }
+        }
+#else
+        std::fwrite(first.data(), 1, first.size(), stdout);
+        std::fwrite(second.data(), 1, second.size(), stdout);
+        if (std::fflush(stdout) != 0 || std::ferror(stdout)) {
+            error_ = errno != 0 ? errno : EIO;
+        }
+#endif
+    }
+
+    int fd_;
+    int error_ = 0;
+    std::vector<char> buffer_;
+};
+
+// How (and whether) sudoku-solver prints the solutions when reading a file
+enum class output_mode { none, lines, pretty };
+
+void write_solution(output_buffer& out, output_mode mode,
+                    const std::optional<tcb::sudoku::grid>& solution)
+{
+    if (mode == output_mode::lines) {
+        if (solution) {
+            char* p = out.extend(82);
+            std::memcpy(p, solution->data(), 81);
+            p[81] = '\n';
+        } else {
+            out.append("no solution\n");
+        }
+    } else if (mode == output_mode::pretty) {
+        if (solution) {
+            char* p = tcb::sudoku::format_to(out.extend(tcb::sudoku::formatted_grid_size + 2),
+                                             *solution);
+            p[0] = '\n';
+            p[1] = '\n';
+        } else {
+            out.append("Could not find solution\n\n");
+        }
+    }
 }
 
-auto solve_from_stream(std::istream& stream, bool interactive)
+// Calls f with each grid in a stream of puzzles, one per line
+template <typename Func>
+void for_each_in_stream(std::istream& stream, Func f)
 {
     std::string s;
-    std::chrono::microseconds total_elapsed{};
-    int num_solved = 0;
     while(std::getline(stream, s)) {
-        auto grid = tcb::sudoku::grid::parse(s);
-        if (!grid) {
-            continue;
+        if (auto grid = tcb::sudoku::grid::parse(s)) {
+            f(*grid);
+        }
+    }
+}
+
+// Removes the first (roughly) n bytes of buffer and returns them, extended to
+// just past the next newline so that no line is split
+auto take_lines(std::string_view& buffer, std::size_t n) -> std::string_view
+{
+    auto end = buffer.size();
+    if (n < buffer.size()) {
+        end = std::min(buffer.find('\n', n), buffer.size() - 1) + 1;
+    }
+    const auto lines = buffer.substr(0, end);
+    buffer.remove_prefix(end);
+    return lines;
+}
+
+// Text is parsed a window at a time, with each window split into chunks of at
+// least min_parse_chunk_size bytes, so that small files are just parsed on
+// the calling thread
+constexpr std::size_t parse_window_size = 64 << 20;
+constexpr std::size_t min_parse_chunk_size = 1 << 20;
+
+// Parses every line of text, splitting it into newline-aligned chunks which
+// are parsed concurrently on the pool (and the calling thread). Each chunk's
+// grids are returned in a vector of their own, in file order.
+auto parse_chunks(std::string_view text, tcb::sudoku::worker_pool& pool)
+    -> std::vector<std::vector<tcb::sudoku::grid>>
+{
+    const auto num_chunks = std::max<std::size_t>(
+        std::min<std::size_t>(pool.size() + 1, text.size() / min_parse_chunk_size), 1);
+    const auto chunk_size = text.size() / num_chunks + 1;
+
+    std::vector<std::string_view> ranges;
+    while (!text.empty()) {
+        ranges.push_back(take_lines(text, chunk_size));
+    }
+    std::vector<std::vector<tcb::sudoku::grid>> chunks(ranges.size());
+
+    auto parse = [&ranges, &chunks](std::size_t i) {
+        auto range = ranges[i];
+        auto& grids = chunks[i];
+        // A puzzle takes at least 82 bytes, with its newline
+        grids.reserve(range.size() / 82 + 1);
+        while (!range.empty()) {
+            const auto end = std::min(range.find('\n'), range.size());
+            auto grid = tcb::sudoku::grid::parse(range.substr(0, end));
+            range.remove_prefix(std::min(end + 1, range.size()));
+            if (grid) {
+                grids.push_back(*grid);
+            }
+        }
+    };
+
+    // The tasks refer to our locals, so we wait for every one of them before
+    // passing on the first error
+    std::vector<std::future<void>> done;
+    std::exception_ptr error;
+    try {
+        done.reserve(ranges.size());
+        for (std::size_t i = 1; i < ranges.size(); i++) {
+            auto task = std::make_shared<std::packaged_task<void()>>([&parse, i] { parse(i); });
+            done.push_back(task->get_future());
+            pool.post([task] { (*task)(); });
+        }
+        if (!ranges.empty()) {
+            parse(0);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& d : done) {
+        try {
+            d.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
         }
-        total_elapsed += solve_one(*grid, interactive);
-        ++num_solved;
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
 
-    return std::make_pair(num_solved, total_elapsed);
+    return chunks;
+}
+
+// Calls f with a packed grid once it has been unpacked. Returns false
+// (without calling f) if the packed grid is corrupt.
+template <typename Func>
+bool unpack_one(const tcb::sudoku::packed_grid& packed, Func& f)
+{
+    auto grid = tcb::sudoku::grid::unpack(packed);
+    if (grid) {
+        f(*grid);
+    }
+    return grid.has_value();
+}
+
+// Calls f with each grid in a buffer holding a whole file of puzzles: either
+// a packed corpus, or text with one puzzle per line, in which case each line
+// is parsed in place. Returns false if the buffer holds a packed corpus whose
+// size doesn't match its header, or which contains a corrupt grid.
+template <typename Func>
+bool for_each_in_buffer(std::string_view buffer, Func f)
+{
+    constexpr std::size_t header_size = 16;
+    if (buffer.substr(0, tcb::sudoku::packed_corpus_magic.size()) ==
+        tcb::sudoku::packed_corpus_magic) {
+        if (buffer.size() < header_size) {
+            return false;
+        }
+        // The count is little-endian, in the second half of the header
+        std::uint64_t count = 0;
+        for (auto i = header_size; i-- > tcb::sudoku::packed_corpus_magic.size(); ) {
+            count = (count << 8) | static_cast<unsigned char>(buffer[i]);
+        }
+        tcb::sudoku::packed_grid packed;
+        const auto body_size = buffer.size() - header_size;
+        if (body_size % packed.size() != 0 || body_size / packed.size() != count) {
+            return false;
+        }
+        for (auto pos = header_size; pos < buffer.size(); pos += packed.size()) {
+            std::memcpy(packed.data(), buffer.data() + pos, packed.size());
+            if (!unpack_one(packed, f)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Parse the text a window at a time, so that we never hold more than one
+    // window's worth of grids in memory
+    auto& pool = tcb::sudoku::worker_pool::default_pool();
+    while (!buffer.empty()) {
+        const auto window = take_lines(buffer, parse_window_size);
+        for (const auto& chunk : parse_chunks(window, pool)) {
+            for (const auto& grid : chunk) {
+                f(grid);
+            }
+        }
+    }
+    return true;
+}
+
+#ifdef TCB_SUDOKU_HAVE_POSIX
+// A read-only mapping of a whole file. Corpora can run to many gigabytes, so
+// we let the kernel page them in (and out again) as we go, rather than
+// copying every line into a string.
+struct mapped_file {
+    explicit mapped_file(const char* filename)
+    {
+        const int fd = ::open(filename, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(addr);
+                size_ = st.st_size;
+            }
+        }
+        ::close(fd);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file()
+    {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    explicit operator bool() const { return data_ != nullptr; }
+
+    auto contents() const -> std::string_view { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+#endif
+
+// Calls f with each grid in the named file
+template <typename Func>
+bool for_each_in_file(const char* filename, Func f)
+{
+#ifdef TCB_SUDOKU_HAVE_POSIX
+    // If the file can't be mapped (it might be a pipe, or empty), fall back
+    // to reading it as a stream
+    if (const mapped_file file{filename}) {
+        return for_each_in_buffer(file.contents(), f);
+    }
+#endif
+    std::ifstream file{filename, std::ios::binary};
+    std::string magic(tcb::sudoku::packed_corpus_magic.size(), '\0');
+    file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    file.clear();
+    file.seekg(0);
+    if (magic == tcb::sudoku::packed_corpus_magic) {
+        // As with a mapped file, the grids must fill the rest of the file
+        const auto packed = tcb::sudoku::read_packed_corpus(file);
+        if (!packed || file.peek() != std::ifstream::traits_type::eof()) {
+            return false;
+        }
+        for (const auto& p : *packed) {
+            if (!unpack_one(p, f)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    for_each_in_stream(file, f);
+    return true;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [--portfolio N] [--backend search|sat] "
+                 "[--propagation LEVEL] [--branching RULE] [--values ORDER] [--backjumping] "
+                 "[--print lines|pretty] [FILE]\n"
+              << "       " << name << " --pack OUT FILE\n"
+              << "  FILE may hold one puzzle per line, or be a packed corpus\n"
+              << "  --pack converts the puzzles in FILE to a packed corpus\n"
+              << "  --print writes each solution to stdout, one per line or as a board\n"
+              << "  LEVEL is one of singles, locked_candidates, subsets, x_wing\n"
+              << "  RULE is one of mrv, mrv_degree, units\n"
+              << "  ORDER is one of ascending, descending, random, least_constraining\n";
+    std::exit(1);
+}
+
+auto parse_propagation(const char* name, const char* arg)
+{
+    using tcb::sudoku::propagation_level;
+    if (std::strcmp(arg, "singles") == 0) {
+        return propagation_level::singles;
+    } else if (std::strcmp(arg, "locked_candidates") == 0) {
+        return propagation_level::locked_candidates;
+    } else if (std::strcmp(arg, "subsets") == 0) {
+        return propagation_level::subsets;
+    } else if (std::strcmp(arg, "x_wing") == 0) {
+        return propagation_level::x_wing;
+    }
+    usage(name);
+    return propagation_level::singles;
+}
+
+auto parse_branching(const char* name, const char* arg)
+{
+    using tcb::sudoku::branching_rule;
+    if (std::strcmp(arg, "mrv") == 0) {
+        return branching_rule::mrv;
+    } else if (std::strcmp(arg, "mrv_degree") == 0) {
+        return branching_rule::mrv_degree;
+    } else if (std::strcmp(arg, "units") == 0) {
+        return branching_rule::units;
+    }
+    usage(name);
+    return branching_rule::mrv;
+}
+
+auto parse_values(const char* name, const char* arg)
+{
+    using tcb::sudoku::value_order;
+    if (std::strcmp(arg, "ascending") == 0) {
+        return value_order::ascending;
+    } else if (std::strcmp(arg, "descending") == 0) {
+        return value_order::descending;
+    } else if (std::strcmp(arg, "random") == 0) {
+        return value_order::random;
+    } else if (std::strcmp(arg, "least_constraining") == 0) {
+        return value_order::least_constraining;
+    }
+    usage(name);
+    return value_order::ascending;
 }
 
 int main(int argc, char** argv)
 {
     std::chrono::microseconds total_elapsed{};
     int num_solved = 0;
+    tcb::sudoku::solve_options options;
+    const char* filename = nullptr;
+    const char* pack_filename = nullptr;
+    auto output = output_mode::none;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_arg = i + 1 < argc;
+        if (std::strcmp(argv[i], "--portfolio") == 0 && has_arg) {
+            options.portfolio = tcb::sudoku::default_portfolio(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--backend") == 0 && has_arg) {
+            ++i;
+            if (std::strcmp(argv[i], "sat") == 0) {
+                options.backend = tcb::sudoku::solver_backend::sat;
+            } else if (std::strcmp(argv[i], "search") == 0) {
+                options.backend = tcb::sudoku::solver_backend::search;
+            } else {
+                usage(argv[0]);
+            }
+        } else if (std::strcmp(argv[i], "--print") == 0 && has_arg) {
+            ++i;
+            if (std::strcmp(argv[i], "lines") == 0) {
+                output = output_mode::lines;
+            } else if (std::strcmp(argv[i], "pretty") == 0) {
+                output = output_mode::pretty;
+            } else {
+                usage(argv[0]);
+            }
+        } else if (std::strcmp(argv[i], "--pack") == 0 && has_arg) {
+            pack_filename = argv[++i];
+        } else if (std::strcmp(argv[i], "--backjumping") == 0) {
+            options.backjumping = true;
+        } else if (std::strcmp(argv[i], "--propagation") == 0 && has_arg) {
+            options.propagation = parse_propagation(argv[0], argv[++i]);
+        } else if (std::strcmp(argv[i], "--branching") == 0 && has_arg) {
+            options.branching = parse_branching(argv[0], argv[++i]);
+        } else if (std::strcmp(argv[i], "--values") == 0 && has_arg) {
+            options.values = parse_values(argv[0], argv[++i]);
+        } else if (argv[i][0] == '-' || filename) {
+            usage(argv[0]);
+        } else {
+            filename = argv[i];
+        }
+    }
 
-    if (argc == 1) {
-        std::tie(num_solved, total_elapsed) = solve_from_stream(std::cin, true);
+    if (pack_filename) {
+        if (!filename) {
+            usage(argv[0]);
+        }
+        std::vector<tcb::sudoku::packed_grid> packed;
+        const bool ok = for_each_in_file(filename, [&] (const tcb::sudoku::grid& grid) {
+            packed.push_back(grid.pack());
+        });
+        if (!ok) {
+            std::cerr << "Error: " << filename << " is not a valid packed corpus\n";
+            return 1;
+        }
+        std::ofstream out{pack_filename, std::ios::binary};
+        tcb::sudoku::write_packed_corpus(out, packed);
+        out.close();
+        if (!out) {
+            std::cerr << "Error writing " << pack_filename << "\n";
+            return 1;
+        }
+        std::cout << "Packed " << packed.size() << " puzzles into " << pack_filename << "\n";
+        return 0;
+    }
+
+    const bool interactive = !filename;
+    if (interactive) {
+        output = output_mode::none;
+    }
+    output_buffer out{1}; // standard output
+    auto solve = [&] (const tcb::sudoku::grid& grid) {
+        auto [elapsed, solution] = solve_one(grid, options, interactive);
+        total_elapsed += elapsed;
+        ++num_solved;
+        write_solution(out, output, solution);
+    };
+    bool ok = true;
+    if (!filename) {
+        for_each_in_stream(std::cin, solve);
     } else {
-        std::ifstream file{argv[1]};
-        std::tie(num_solved, total_elapsed) = solve_from_stream(file, false);
+        ok = for_each_in_file(filename, solve);
+    }
+    out.flush();
+    if (!ok) {
+        std::cerr << "Error: " << filename << " is not a valid packed corpus\n";
+        return 1;
+    }
+    if (out.error() != 0) {
+        std::cerr << "Error writing solutions: " << std::strerror(out.error()) << "\n";
+        return 1;
     }
 
-    std::cout << "Solved " << num_solved << " puzzles in " << total_elapsed.count()/1000.0 << "ms\n";
-    std::cout << "(Average " << total_elapsed.count()/(1000.0 * num_solved) << "ms per puzzle)\n";
+    // Keep the solutions and the summary apart
+    auto& summary = output == output_mode::none ? std::cout : std::cerr;
+    summary << "Solved " << num_solved << " puzzles in " << total_elapsed.count()/1000.0 << "ms\n";
+    summary << "(Average " << total_elapsed.count()/(1000.0 * num_solved) << "ms per puzzle)\n";
+    if (options.portfolio.empty()) {
+        summary << total_stats.guesses << " guesses, " << total_stats.backtracks
+                << " backtracks, " << total_stats.backjumps << " backjumps\n";
+    }
 }
\ No newline at end of file
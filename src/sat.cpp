@@ -0,0 +1,427 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#include "sat.hpp"
+#include "tables.hpp"
+
+#include <algorithm>
+
+namespace tcb {
+namespace sudoku {
+namespace detail {
+
+namespace {
+
+// Literals are numbered 2v for "variable v is true" and 2v + 1 for "variable
+// v is false". Variable 9c + (d - 1) says that cell c contains digit d.
+constexpr auto var_of(int cell, int digit) -> int { return cell * 9 + digit - 1; }
+
+constexpr auto pos(int var) -> int { return 2 * var; }
+
+constexpr auto neg(int var) -> int { return 2 * var + 1; }
+
+// The number of conflicts in the shortest run between restarts
+constexpr int restart_unit = 100;
+
+}
+
+sat_solver::sat_solver()
+{
+    // Each cell contains at least one digit, and no two
+    for (int cell = 0; cell < 81; cell++) {
+        std::array<int, 9> clause;
+        for (int d = 1; d < 10; d++) {
+            clause[d - 1] = pos(var_of(cell, d));
+        }
+        add_clause(clause.data(), 9);
+        for (int d1 = 1; d1 < 10; d1++) {
+            for (int d2 = d1 + 1; d2 < 10; d2++) {
+                const int pair[] = {neg(var_of(cell, d1)), neg(var_of(cell, d2))};
+                add_clause(pair, 2);
+            }
+        }
+    }
+
+    // Each digit appears at least once in each unit, and not twice
+    for (const auto& unit : unit_indices) {
+        for (int d = 1; d < 10; d++) {
+            std::array<int, 9> clause;
+            for (int i = 0; i < 9; i++) {
+                clause[i] = pos(var_of(unit[i], d));
+            }
+            add_clause(clause.data(), 9);
+            for (int i = 0; i < 9; i++) {
+                for (int j = i + 1; j < 9; j++) {
+                    const int pair[] = {neg(var_of(unit[i], d)), neg(var_of(unit[j], d))};
+                    add_clause(pair, 2);
+                }
+            }
+        }
+    }
+
+    num_problem_lits_ = lits_.size();
+    num_problem_clauses_ = clauses_.size();
+    trail_.reserve(num_vars);
+    trail_lim_.reserve(num_vars);
+    learnt_.reserve(num_vars);
+}
+
+auto sat_solver::value(int lit) const -> int
+{
+    const auto a = assigns_[lit >> 1];
+    return a < 0 ? -1 : (a ^ (lit & 1));
+}
+
+void sat_solver::add_clause(const int* lits, int size)
+{
+    clauses_.push_back({static_cast<int>(lits_.size()), size});
+    lits_.insert(lits_.end(), lits, lits + size);
+}
+
+void sat_solver::attach(int cref)
+{
+    const auto& c = clauses_[cref];
+    watches_[lits_[c.start]].push_back(cref);
+    watches_[lits_[c.start + 1]].push_back(cref);
+}
+
+// Re-attaches every clause, watching literals which aren't false if
+// possible. This is only done at decision level 0, where everything which
+// can be propagated already has been.
+void sat_solver::rebuild_watches()
+{
+    for (auto& w : watches_) {
+        w.clear();
+    }
+    for (std::size_t cref = 0; cref < clauses_.size(); cref++) {
+        const auto& c = clauses_[cref];
+        auto* lits = &lits_[c.start];
+        std::stable_partition(lits, lits + c.size, [this](int lit) { return value(lit) != 0; });
+        attach(static_cast<int>(cref));
+    }
+}
+
+void sat_solver::enqueue(int lit, int reason)
+{
+    const int v = lit >> 1;
+    assigns_[v] = static_cast<std::int8_t>((lit & 1) ^ 1);
+    level_[v] = decision_level();
+    reason_[v] = reason;
+    trail_.push_back(lit);
+}
+
+// Propagates everything on the trail which hasn't been yet. Returns the
+// index of a clause with every literal false, or no_reason if there's
+// no conflict.
+auto sat_solver::propagate() -> int
+{
+    while (qhead_ < trail_.size()) {
+        const int false_lit = trail_[qhead_++] ^ 1;
+        auto& ws = watches_[false_lit];
+
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < ws.size()) {
+            const int cref = ws[i++];
+            const auto& c = clauses_[cref];
+            auto* lits = &lits_[c.start];
+
+            // Make sure the false literal is the second watch
+            if (lits[0] == false_lit) {
+                std::swap(lits[0], lits[1]);
+            }
+
+            // If the other watch is true, the clause is satisfied
+            if (value(lits[0]) == 1) {
+                ws[j++] = cref;
+                continue;
+            }
+
+            // Look for another literal to watch instead
+            bool found = false;
+            for (int k = 2; k < c.size; k++) {
+                if (value(lits[k]) != 0) {
+                    std::swap(lits[1], lits[k]);
+                    watches_[lits[1]].push_back(cref);
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                continue;
+            }
+
+            // Otherwise the clause is unit or conflicting
+            ws[j++] = cref;
+            if (value(lits[0]) == 0) {
+                while (i < ws.size()) {
+                    ws[j++] = ws[i++];
+                }
+                ws.resize(j);
+                qhead_ = trail_.size();
+                return cref;
+            }
+            enqueue(lits[0], cref);
+        }
+        ws.resize(j);
+    }
+    return no_reason;
+}
+
+// Works out a clause which explains the conflict, containing exactly one
+// literal from the current decision level (the first unique implication
+// point), and the level to go back to so that the clause becomes unit
+void sat_solver::analyze(int confl, std::vector<int>& learnt, int& backtrack_level)
+{
+    learnt.clear();
+    learnt.push_back(-1);
+
+    int path = 0;
+    int p = -1;
+    auto index = trail_.size();
+
+    do {
+        const auto& c = clauses_[confl];
+        const auto* lits = &lits_[c.start];
+        for (int j = (p < 0) ? 0 : 1; j < c.size; j++) {
+            const int q = lits[j];
+            const int v = q >> 1;
+            if (!seen_[v] && level_[v] > 0) {
+                seen_[v] = true;
+                bump(v);
+                if (level_[v] >= decision_level()) {
+                    ++path;
+                } else {
+                    learnt.push_back(q);
+                }
+            }
+        }
+
+        // Find the most recent literal we've looked at on the trail
+        while (!seen_[trail_[--index] >> 1]) {}
+        p = trail_[index];
+        confl = reason_[p >> 1];
+        seen_[p >> 1] = false;
+        --path;
+    } while (path > 0);
+    learnt[0] = p ^ 1;
+
+    backtrack_level = 0;
+    for (std::size_t i = 1; i < learnt.size(); i++) {
+        seen_[learnt[i] >> 1] = false;
+        if (level_[learnt[i] >> 1] > backtrack_level) {
+            backtrack_level = level_[learnt[i] >> 1];
+            std::swap(learnt[1], learnt[i]);
+        }
+    }
+}
+
+void sat_solver::cancel_until(int level)
+{
+    if (decision_level() <= level) {
+        return;
+    }
+    for (auto i = trail_.size(); i-- > static_cast<std::size_t>(trail_lim_[level]); ) {
+        const int v = trail_[i] >> 1;
+        polarity_[v] = (trail_[i] & 1) == 0;
+        assigns_[v] = -1;
+        reason_[v] = no_reason;
+    }
+    trail_.resize(trail_lim_[level]);
+    trail_lim_.resize(level);
+    qhead_ = trail_.size();
+}
+
+void sat_solver::bump(int var)
+{
+    if ((activity_[var] += var_inc_) > 1e100) {
+        for (auto& a : activity_) {
+            a *= 1e-100;
+        }
+        var_inc_ *= 1e-100;
+    }
+}
+
+// Returns the literal to decide next: the unassigned variable with the
+// highest activity, with the polarity it had last time. Returns -1 if every
+// variable is assigned.
+auto sat_solver::pick_branch() -> int
+{
+    int best = -1;
+    for (int v = 0; v < num_vars; v++) {
+        if (assigns_[v] < 0 && (best < 0 || activity_[v] > activity_[best])) {
+            best = v;
+        }
+    }
+    if (best < 0) {
+        return -1;
+    }
+    return polarity_[best] ? pos(best) : neg(best);
+}
+
+// Throws away the longer half of the learnt clauses
+void sat_solver::reduce_learnts()
+{
+    const auto num_learnts = clauses_.size() - num_problem_clauses_;
+    if (num_learnts <= max_learnts_) {
+        return;
+    }
+
+    // The learnt clause buffer isn't in use between runs, so borrow it
+    std::vector<int>& sizes = learnt_;
+    sizes.clear();
+    for (auto i = num_problem_clauses_; i < clauses_.size(); i++) {
+        sizes.push_back(clauses_[i].size);
+    }
+    std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+    const int max_size = sizes[sizes.size() / 2];
+
+    auto out_clause = num_problem_clauses_;
+    auto out_lit = num_problem_lits_;
+    for (auto i = num_problem_clauses_; i < clauses_.size(); i++) {
+        const auto c = clauses_[i];
+        if (c.size > max_size || (c.size == max_size && (i & 1))) {
+            continue;
+        }
+        std::copy(lits_.begin() + c.start, lits_.begin() + c.start + c.size,
+                  lits_.begin() + static_cast<std::ptrdiff_t>(out_lit));
+        clauses_[out_clause++] = {static_cast<int>(out_lit), c.size};
+        out_lit += static_cast<std::size_t>(c.size);
+    }
+    clauses_.resize(out_clause);
+    lits_.resize(out_lit);
+
+    // We're at level 0, so no reasons will be looked at again
+    for (int lit : trail_) {
+        reason_[lit >> 1] = no_reason;
+    }
+    rebuild_watches();
+    max_learnts_ += max_learnts_ / 10;
+}
+
+// Runs until a solution is found (returns 1), the problem is shown to be
+// unsatisfiable (returns 0) or we reach the conflict limit or are cancelled
+// (returns -1)
+auto sat_solver::search(int conflict_limit) -> int
+{
+    int conflicts = 0;
+    while (true) {
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+            cancel_until(0);
+            return -1;
+        }
+
+        const int confl = propagate();
+        if (confl != no_reason) {
+            ++stats_.backtracks;
+            ++conflicts;
+            if (decision_level() == 0) {
+                return 0;
+            }
+
+            int backtrack_level = 0;
+            analyze(confl, learnt_, backtrack_level);
+            cancel_until(backtrack_level);
+            if (learnt_.size() == 1) {
+                enqueue(learnt_[0], no_reason);
+            } else {
+                add_clause(learnt_.data(), static_cast<int>(learnt_.size()));
+                const int cref = static_cast<int>(clauses_.size()) - 1;
+                attach(cref);
+                enqueue(learnt_[0], cref);
+            }
+            var_inc_ /= 0.95;
+            continue;
+        }
+
+        if (conflicts >= conflict_limit) {
+            cancel_until(0);
+            return -1;
+        }
+
+        const int next = pick_branch();
+        if (next < 0) {
+            return 1;
+        }
+        ++stats_.guesses;
+        trail_lim_.push_back(static_cast<int>(trail_.size()));
+        enqueue(next, no_reason);
+    }
+}
+
+auto sat_solver::solve(const candidates_t& candidates,
+                       std::array<std::uint8_t, 81>& solution) -> bool
+{
+    stats_ = {};
+    finished_ = false;
+
+    // Forget everything from last time
+    lits_.resize(num_problem_lits_);
+    clauses_.resize(num_problem_clauses_);
+    assigns_.fill(-1);
+    reason_.fill(no_reason);
+    polarity_.fill(true);
+    seen_.fill(false);
+    activity_.fill(0.0);
+    var_inc_ = 1.0;
+    trail_.clear();
+    trail_lim_.clear();
+    qhead_ = 0;
+    max_learnts_ = 2000;
+    rebuild_watches();
+
+    // The candidates which have already been ruled out are unit clauses
+    for (int cell = 0; cell < 81; cell++) {
+        for (int d = 1; d < 10; d++) {
+            if ((candidates[cell] & (1u << (d - 1))) == 0) {
+                enqueue(neg(var_of(cell, d)), no_reason);
+            }
+        }
+    }
+
+    for (int run = 1; ; run++) {
+        const int result = search(static_cast<int>(luby(run)) * restart_unit);
+        if (result >= 0) {
+            finished_ = true;
+            if (result == 0) {
+                return false;
+            }
+            for (int cell = 0; cell < 81; cell++) {
+                for (int d = 1; d < 10; d++) {
+                    if (assigns_[var_of(cell, d)] == 1) {
+                        solution[cell] = static_cast<std::uint8_t>(d);
+                    }
+                }
+            }
+            return true;
+        }
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+            return false;
+        }
+        ++stats_.restarts;
+        reduce_learnts();
+    }
+}
+
+} // end namespace detail
+} // end namespace sudoku
+} // end namespace tcb
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#ifndef TCB_SUDOKU_SAT_HPP
+#define TCB_SUDOKU_SAT_HPP
+
+#include <tcb/sudoku.hpp>
+#include "solver.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace tcb {
+namespace sudoku {
+namespace detail {
+
+// A small CDCL SAT solver, specialised to the standard sudoku encoding: one
+// variable for each (cell, digit) pair, with clauses saying that each cell
+// has exactly one digit, and each digit appears exactly once in each row,
+// column and box. It uses two watched literals per clause, first-UIP clause
+// learning with non-chronological backtracking, VSIDS-style variable
+// activities with phase saving, and Luby restarts.
+//
+// The sudoku clauses are built once, when the solver is created. Each call
+// to solve() adds the givens as unit clauses and throws away whatever was
+// learned last time, but keeps its buffers, so after the first few puzzles
+// solving rarely allocates.
+class sat_solver {
+public:
+    sat_solver();
+
+    // Returns true if the candidates can be completed, in which case
+    // `solution` holds the digit for each cell
+    auto solve(const candidates_t& candidates, std::array<std::uint8_t, 81>& solution) -> bool;
+
+    // True if the last solve() finished (rather than being cancelled)
+    auto finished() const -> bool { return finished_; }
+
+    auto stats() const -> const solve_stats& { return stats_; }
+
+    // If this is set, solve() gives up as soon as it becomes true
+    const std::atomic<bool>* cancelled = nullptr;
+
+private:
+    static constexpr int num_vars = 81 * 9;
+    static constexpr int no_reason = -1;
+
+    struct clause_t {
+        int start;
+        int size;
+    };
+
+    auto value(int lit) const -> int;
+    void add_clause(const int* lits, int size);
+    void attach(int cref);
+    void rebuild_watches();
+    void enqueue(int lit, int reason);
+    auto propagate() -> int;
+    void analyze(int confl, std::vector<int>& learnt, int& backtrack_level);
+    void cancel_until(int level);
+    void bump(int var);
+    auto pick_branch() -> int;
+    void reduce_learnts();
+    auto search(int conflict_limit) -> int;
+
+    auto decision_level() const -> int { return static_cast<int>(trail_lim_.size()); }
+
+    // All the clauses' literals, one after the other. The sudoku clauses
+    // come first; learnt ones are appended after them.
+    std::vector<int> lits_;
+    std::vector<clause_t> clauses_;
+    std::size_t num_problem_lits_ = 0;
+    std::size_t num_problem_clauses_ = 0;
+    std::size_t max_learnts_ = 0;
+
+    std::array<std::vector<int>, 2 * num_vars> watches_;
+    std::array<std::int8_t, num_vars> assigns_;
+    std::array<int, num_vars> level_;
+    std::array<int, num_vars> reason_;
+    std::array<bool, num_vars> polarity_;
+    std::array<bool, num_vars> seen_;
+    std::array<double, num_vars> activity_;
+    double var_inc_ = 1.0;
+
+    std::vector<int> trail_;
+    std::vector<int> trail_lim_;
+    std::size_t qhead_ = 0;
+    std::vector<int> learnt_;
+
+    solve_stats stats_{};
+    bool finished_ = false;
+};
+
+} // end namespace detail
+} // end namespace sudoku
+} // end namespace tcb
+
+#endif
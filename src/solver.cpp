@@ -21,6 +21,8 @@ SOFTWARE.
  */
 
 #include <tcb/sudoku.hpp>
+#include "sat.hpp"
+#include "solver.hpp"
 #include "tables.hpp"
 
 #include <range/v3/algorithm/all_of.hpp>
@@ -32,7 +34,14 @@ SOFTWARE.
 #include <range/v3/view/filter.hpp>
 #include <range/v3/view/iota.hpp>
 #include <range/v3/view/transform.hpp>
-#include <range/v3/view/zip.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #ifdef _MSC_VER
 #include <intrin.h> 
@@ -46,14 +55,6 @@ namespace rng = ranges;
 
 namespace {
 
-auto enumerate()
-{
-    return rng::make_pipeable([](auto&& range) {
-        using range_t = decltype(range);
-        return rng::views::zip(rng::views::iota(0), std::forward<range_t>(range));
-    });
-}
-
 const auto& get_peers(int index)
 {
     return peers_indices[index];
@@ -75,10 +76,14 @@ const auto& get_box(int index)
 }
 
 struct cell_t {
-    cell_t() : bits(0b111'111'111) {}
+    cell_t() : bits(detail::all_candidates) {}
+
+    explicit cell_t(std::uint16_t candidates) : bits(candidates) {}
 
     bool could_be(int i) const { return (bits & (1 << (i - 1))) != 0; }
 
+    auto candidates() const -> std::uint16_t { return bits; }
+
     void remove(int i) { bits &= ~(1 << (i - 1)); }
 
     auto count() const
@@ -160,20 +165,117 @@ auto eliminate(puzzle_t& p, int index, int value) -> bool
     });
 }
 
-auto grid_to_puzzle(const grid& g) -> std::optional<puzzle_t>
+// A set of digits for each row, column and box, with bit (n - 1) set for the
+// digit n
+struct unit_masks {
+    std::array<std::uint16_t, 9> rows{};
+    std::array<std::uint16_t, 9> columns{};
+    std::array<std::uint16_t, 9> boxes{};
+
+    auto any() const -> bool
+    {
+        std::uint16_t all = 0;
+        for (int i = 0; i < 9; i++) {
+            all |= rows[i] | columns[i] | boxes[i];
+        }
+        return all != 0;
+    }
+
+    // Returns the digits in any of the units containing the given cell
+    auto of(int index) const -> std::uint16_t
+    {
+        const int row = index / 9;
+        const int col = index % 9;
+        return rows[row] | columns[col] | boxes[row / 3 * 3 + col / 3];
+    }
+};
+
+// The digits used by the givens of a grid, and those used more than once
+struct given_masks {
+    unit_masks used;
+    unit_masks repeated;
+};
+
+// '.' maps to no bits at all, so unknown cells never clash
+auto digit_bit(char c) -> std::uint16_t
+{
+    return c == '.' ? 0 : static_cast<std::uint16_t>(1u << (c - '1'));
+}
+
+// Collects the masks in a single pass over the grid, without branching on
+// the cell contents
+auto scan_givens(grid_view g) -> given_masks
+{
+    given_masks masks;
+    auto& used = masks.used;
+    auto& repeated = masks.repeated;
+    for (int row = 0; row < 9; row++) {
+        for (int col = 0; col < 9; col++) {
+            const auto bit = digit_bit(g[row * 9 + col]);
+            const int box = row / 3 * 3 + col / 3;
+            repeated.rows[row] |= used.rows[row] & bit;
+            repeated.columns[col] |= used.columns[col] & bit;
+            repeated.boxes[box] |= used.boxes[box] & bit;
+            used.rows[row] |= bit;
+            used.columns[col] |= bit;
+            used.boxes[box] |= bit;
+        }
+    }
+    return masks;
+}
+
+auto grid_to_puzzle(grid_view g) -> std::optional<puzzle_t>
 {
+    // Grids with the same digit twice in a unit are cheap to spot, so
+    // reject them before doing any propagation
+    const auto masks = scan_givens(g);
+    if (masks.repeated.any()) {
+        return std::nullopt;
+    }
+
+    // Rather than assigning the givens one at a time, place them all at
+    // once, and take their digits out of their peers using the masks
     auto puzzle = puzzle_t{};
-    auto view = rng::views::all(g)
-                | enumerate()
-                | rng::views::filter([] (const auto& pair) {
-        return pair.second != '.';
-    });
-    if (rng::all_of(view, [&] (const auto& pair) {
-        return assign(puzzle, pair.first, pair.second - '0');
-    })) {
-        return puzzle;
+    for (int i = 0; i < 81; i++) {
+        const auto bit = digit_bit(g[i]);
+        const auto candidates = bit != 0 ? bit : detail::all_candidates & ~masks.used.of(i);
+        if (candidates == 0) {
+            return std::nullopt;
+        }
+        puzzle[i] = cell_t{static_cast<std::uint16_t>(candidates)};
     }
-    return std::nullopt;
+
+    // The masks leave the puzzle as if every given had been assigned, except
+    // that nothing has been done about the cells and units they reduced to
+    // a single possibility. Deal with those, after which eliminate() and
+    // assign() carry on propagating as usual.
+    for (int i = 0; i < 81; i++) {
+        if (g[i] == '.' && puzzle[i].count() == 1) {
+            const auto d = puzzle[i].get_value();
+            if (!rng::all_of(get_peers(i), [&](auto peer) { return eliminate(puzzle, peer, d); })) {
+                return std::nullopt;
+            }
+        }
+    }
+    for (const auto& unit : unit_indices) {
+        for (int d = 1; d <= 9; d++) {
+            int place = -1;
+            int count = 0;
+            for (int idx : unit) {
+                if (puzzle[idx].could_be(d)) {
+                    place = idx;
+                    ++count;
+                }
+            }
+            if (count == 0) {
+                return std::nullopt;
+            }
+            if (count == 1 && puzzle[place].count() > 1 && !assign(puzzle, place, d)) {
+                return std::nullopt;
+            }
+        }
+    }
+    return puzzle;
 }
 
 auto puzzle_to_grid(const puzzle_t& p) -> grid
@@ -190,11 +292,13 @@ auto puzzle_to_grid(const puzzle_t& p) -> grid
     return std::move(*grid::parse({array.data(), 81}));
 }
 
-auto do_solve(const puzzle_t& p) -> std::optional<puzzle_t>
+// Returns the index of one of the cells with the fewest possibilities, or -1
+// if every cell is already known
+auto select_cell(const puzzle_t& p) -> int
 {
     // If all cells have only one possibility, we're done
     if (rng::all_of(p, [](const auto& c) { return c.count() == 1; })) {
-        return std::move(p);
+        return -1;
     }
 
     // Otherwise, make a list of indices that have more than one possibility
@@ -203,49 +307,1585 @@ auto do_solve(const puzzle_t& p) -> std::optional<puzzle_t>
     });
 
     // Choose one of the elements with the fewest possibilities
-    auto min_idx = rng::min(non_fixed_cells, [&](int idx1, int idx2) {
+    return rng::min(non_fixed_cells, [&](int idx1, int idx2) {
         return p[idx1].count() < p[idx2].count();
     });
+}
 
-    // Now try each value in the range [1, 9] in the cell at min_idx
-    auto maybe_solutions = rng::views::iota(1, 10)
-            | rng::views::filter([&](int i) { return p[min_idx].could_be(i); })
-            | rng::views::transform([&] (int i) {
-                // Take a new copy of the puzzle and try to assign i to the chosen index
-                auto p_copy = p;
-                // if the assignment succeeded (generated no contradictions),
-                // recursively try to solve the new puzzle
-                if (assign(p_copy, min_idx, i)) {
-                    return do_solve(p_copy);
+// Returns the smallest digit in a (non-empty) candidate mask
+auto lowest_digit(std::uint16_t mask) -> int
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return static_cast<int>(idx) + 1;
+#else
+    return __builtin_ctz(mask) + 1;
+#endif
+}
+
+// Returns the largest digit in a (non-empty) candidate mask
+auto highest_digit(std::uint16_t mask) -> int
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse(&idx, mask);
+    return static_cast<int>(idx) + 1;
+#else
+    return 32 - __builtin_clz(mask);
+#endif
+}
+
+// The outcome of applying one of the stronger deduction rules
+enum class deduction { none, progress, contradiction };
+
+// Eliminates each of the digits in `mask` from a cell
+auto eliminate_all(puzzle_t& p, int index, std::uint16_t mask) -> deduction
+{
+    auto result = deduction::none;
+    for (mask &= p[index].candidates(); mask != 0; mask &= mask - 1) {
+        if (!eliminate(p, index, lowest_digit(mask))) {
+            return deduction::contradiction;
+        }
+        result = deduction::progress;
+    }
+    return result;
+}
+
+// Returns the positions (as a bitmask) within unit u where digit d could
+// still go, not counting cells whose value is already known
+auto places(const puzzle_t& p, int u, int d) -> std::uint16_t
+{
+    std::uint16_t mask = 0;
+    for (int pos = 0; pos < 9; pos++) {
+        const auto& cell = p[unit_indices[u][pos]];
+        if (cell.count() > 1 && cell.could_be(d)) {
+            mask |= 1u << pos;
+        }
+    }
+    return mask;
+}
+
+// The indices (into unit_indices) of the row, column and box of a cell
+auto units_of(int index) -> std::array<int, 3>
+{
+    return {{index / 9, 9 + index % 9, 18 + (index / 27) * 3 + (index % 9) / 3}};
+}
+
+auto in_unit(int index, int u) -> bool
+{
+    const auto units = units_of(index);
+    return units[0] == u || units[1] == u || units[2] == u;
+}
+
+// Locked candidates. If the places for a digit within one unit all lie in
+// some other unit as well (a box and a row, say), then the digit must go in
+// the overlap, and can be eliminated from the rest of the second unit.
+auto locked_candidates(puzzle_t& p) -> deduction
+{
+    for (int u = 0; u < 27; u++) {
+        for (int d = 1; d < 10; d++) {
+            const auto where = places(p, u, d);
+            if (cell_t{where}.count() < 2) {
+                // Either there's nothing to do, or it's a hidden single
+                // which the basic propagation has already dealt with
+                continue;
+            }
+
+            auto common = units_of(unit_indices[u][lowest_digit(where) - 1]);
+            for (auto mask = where; mask != 0; mask &= mask - 1) {
+                const auto units = units_of(unit_indices[u][lowest_digit(mask) - 1]);
+                for (int k = 0; k < 3; k++) {
+                    if (common[k] != units[k]) {
+                        common[k] = -1;
+                    }
                 }
-                return std::optional<puzzle_t>{};
-            });
+            }
 
-    // FIXME: We should be able to filter the above view with view::filter(),
-    // and then just use `if (begin(solns) != end(solns)) { return front(solns) }`
-    // here. But that seems to be very much slower than using a for loop, even
-    // though it should be equivalent.
-    for (auto&& opt : maybe_solutions) {
-        if (opt) {
-            return std::move(opt);
+            for (int v : common) {
+                if (v < 0 || v == u) {
+                    continue;
+                }
+                auto result = deduction::none;
+                for (int idx : unit_indices[v]) {
+                    if (!in_unit(idx, u) && p[idx].count() > 1 && p[idx].could_be(d)) {
+                        if (!eliminate(p, idx, d)) {
+                            return deduction::contradiction;
+                        }
+                        result = deduction::progress;
+                    }
+                }
+                if (result != deduction::none) {
+                    return result;
+                }
+            }
         }
     }
-    return std::nullopt;
+    return deduction::none;
 }
 
+// Looks for a set of `size` items (from nine) for which the union of their
+// masks has exactly `size` bits, and calls f(items, union) for each one
+// until f returns something other than deduction::none
+template <typename Func>
+auto find_subsets(const std::array<std::uint16_t, 9>& masks, int size, Func f) -> deduction
+{
+    auto fits = [&](int i) {
+        const auto n = cell_t{masks[i]}.count();
+        return n >= 2 && n <= size;
+    };
+
+    for (int i = 0; i < 9; i++) {
+        if (!fits(i)) {
+            continue;
+        }
+        for (int j = i + 1; j < 9; j++) {
+            if (!fits(j)) {
+                continue;
+            }
+            const auto ij = static_cast<std::uint16_t>(masks[i] | masks[j]);
+            if (size == 2) {
+                if (cell_t{ij}.count() == 2) {
+                    const auto r = f(static_cast<std::uint16_t>((1u << i) | (1u << j)), ij);
+                    if (r != deduction::none) {
+                        return r;
+                    }
+                }
+                continue;
+            }
+            for (int k = j + 1; k < 9; k++) {
+                if (!fits(k)) {
+                    continue;
+                }
+                const auto ijk = static_cast<std::uint16_t>(ij | masks[k]);
+                if (cell_t{ijk}.count() == 3) {
+                    const auto r = f(static_cast<std::uint16_t>((1u << i) | (1u << j) | (1u << k)), ijk);
+                    if (r != deduction::none) {
+                        return r;
+                    }
+                }
+            }
+        }
+    }
+    return deduction::none;
 }
 
-auto solve(const grid& g) -> std::optional<grid>
+// Naked and hidden pairs and triples. If n cells in a unit can only contain
+// n digits between them, those digits can't go anywhere else in the unit
+// (naked); if n digits can only go in n cells, those cells can't contain
+// anything else (hidden).
+auto subsets(puzzle_t& p, int size) -> deduction
 {
-    auto puzzle = grid_to_puzzle(g);
-    if (!puzzle) {
-        return std::nullopt;
+    for (int u = 0; u < 27; u++) {
+        const auto& unit = unit_indices[u];
+
+        std::array<std::uint16_t, 9> cells{};
+        for (int pos = 0; pos < 9; pos++) {
+            if (p[unit[pos]].count() > 1) {
+                cells[pos] = p[unit[pos]].candidates();
+            }
+        }
+        auto r = find_subsets(cells, size, [&](std::uint16_t positions, std::uint16_t digits) {
+            auto result = deduction::none;
+            for (int pos = 0; pos < 9; pos++) {
+                if ((positions & (1u << pos)) == 0 && cells[pos] != 0) {
+                    const auto r = eliminate_all(p, unit[pos], digits);
+                    if (r == deduction::contradiction) {
+                        return r;
+                    }
+                    result = std::max(result, r);
+                }
+            }
+            return result;
+        });
+        if (r != deduction::none) {
+            return r;
+        }
+
+        std::array<std::uint16_t, 9> digits{};
+        for (int d = 1; d < 10; d++) {
+            digits[d - 1] = places(p, u, d);
+        }
+        r = find_subsets(digits, size, [&](std::uint16_t ds, std::uint16_t positions) {
+            auto result = deduction::none;
+            for (auto mask = positions; mask != 0; mask &= mask - 1) {
+                const int pos = lowest_digit(mask) - 1;
+                const auto r = eliminate_all(p, unit[pos], static_cast<std::uint16_t>(~ds & detail::all_candidates));
+                if (r == deduction::contradiction) {
+                    return r;
+                }
+                result = std::max(result, r);
+            }
+            return result;
+        });
+        if (r != deduction::none) {
+            return r;
+        }
+    }
+    return deduction::none;
+}
+
+// X-Wings. If a digit can only go in the same two columns in each of two
+// rows, then it must go in those columns in those two rows, so it can be
+// eliminated from the rest of both columns; and the same with rows and
+// columns swapped.
+auto x_wings(puzzle_t& p) -> deduction
+{
+    // Rows are units 0-8 and columns 9-17. Position n in a row is in
+    // column n, and position n in a column is in row n.
+    for (int base : {0, 9}) {
+        const int cover = 9 - base;
+        for (int d = 1; d < 10; d++) {
+            std::array<std::uint16_t, 9> where{};
+            for (int i = 0; i < 9; i++) {
+                where[i] = places(p, base + i, d);
+            }
+            for (int i = 0; i < 9; i++) {
+                if (cell_t{where[i]}.count() != 2) {
+                    continue;
+                }
+                for (int j = i + 1; j < 9; j++) {
+                    if (where[j] != where[i]) {
+                        continue;
+                    }
+                    auto result = deduction::none;
+                    for (auto mask = where[i]; mask != 0; mask &= mask - 1) {
+                        const auto& line = unit_indices[cover + lowest_digit(mask) - 1];
+                        for (int pos = 0; pos < 9; pos++) {
+                            const int idx = line[pos];
+                            if (pos != i && pos != j && p[idx].count() > 1 && p[idx].could_be(d)) {
+                                if (!eliminate(p, idx, d)) {
+                                    return deduction::contradiction;
+                                }
+                                result = deduction::progress;
+                            }
+                        }
+                    }
+                    if (result != deduction::none) {
+                        return result;
+                    }
+                }
+            }
+        }
     }
-    auto result = do_solve(*puzzle);
-    if (result) {
-        return puzzle_to_grid(*result);
+    return deduction::none;
+}
+
+// Applies the deduction rules enabled by `level` (beyond the singles which
+// assign() and eliminate() already take care of) until none of them can make
+// any more progress. Returns false if the puzzle turns out to be impossible.
+auto deduce(puzzle_t& p, propagation_level level) -> bool
+{
+    if (level == propagation_level::singles) {
+        return true;
     }
-    return std::nullopt;
+
+    while (true) {
+        // Try the cheapest rules first, and go back to them whenever one of
+        // the more expensive ones makes progress
+        auto r = locked_candidates(p);
+        if (r == deduction::none && level >= propagation_level::subsets) {
+            r = subsets(p, 2);
+            if (r == deduction::none) {
+                r = subsets(p, 3);
+            }
+        }
+        if (r == deduction::none && level >= propagation_level::x_wing) {
+            r = x_wings(p);
+        }
+
+        if (r == deduction::contradiction) {
+            return false;
+        }
+        if (r == deduction::none) {
+            return true;
+        }
+    }
+}
+
+// A small, fast pseudo-random generator (splitmix64). We only need the
+// choices to be reasonably well spread and reproducible from the seed.
+struct random_t {
+    std::uint64_t state = 0;
+
+    auto next() -> std::uint64_t
+    {
+        auto z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    // Returns a number in [0, n)
+    auto below(std::uint32_t n) -> std::uint32_t
+    {
+        return static_cast<std::uint32_t>(((next() >> 32) * n) >> 32);
+    }
+};
+
+// Random keys for Zobrist hashing: the hash of a puzzle is the XOR of the
+// keys of every (cell, digit) candidate it still has
+constexpr auto make_zobrist_keys()
+{
+    std::array<std::array<std::uint64_t, 9>, 81> keys{};
+    std::uint64_t state = 0x5eed'50d0'c0de'f00d;
+    for (auto& cell : keys) {
+        for (auto& key : cell) {
+            auto z = (state += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            key = z ^ (z >> 31);
+        }
+    }
+    return keys;
+}
+
+constexpr auto zobrist_keys = make_zobrist_keys();
+
+// Returns the hash of the candidates in `removed` from the given cell
+auto zobrist_cell(int index, std::uint16_t removed) -> std::uint64_t
+{
+    std::uint64_t hash = 0;
+    for (; removed != 0; removed &= removed - 1) {
+        hash ^= zobrist_keys[index][lowest_digit(removed) - 1];
+    }
+    return hash;
+}
+
+auto zobrist_hash(const puzzle_t& p) -> std::uint64_t
+{
+    std::uint64_t hash = 0;
+    for (int i = 0; i < 81; i++) {
+        hash ^= zobrist_cell(i, p[i].candidates());
+    }
+    return hash;
+}
+
+// Given the hash of `parent`, returns the hash of `child`, which has the
+// same candidates apart from some that have been eliminated. Only the cells
+// which have changed need to be looked at.
+auto zobrist_update(std::uint64_t hash, const puzzle_t& parent, const puzzle_t& child)
+    -> std::uint64_t
+{
+    for (int i = 0; i < 81; i++) {
+        const auto before = parent[i].candidates();
+        const auto after = child[i].candidates();
+        if (before != after) {
+            hash ^= zobrist_cell(i, static_cast<std::uint16_t>(before & ~after));
+        }
+    }
+    return hash;
+}
+
+// A fixed-size table which remembers how many solutions (possibly none)
+// each candidate state it has seen has, keyed by Zobrist hash. Each hash has
+// only one slot, and newer states replace older ones. What it records is
+// true whichever puzzle the state came from, so it can be kept from one
+// solve to the next.
+struct transposition_table {
+    struct entry {
+        std::uint64_t key = 0;
+        std::uint64_t solutions = 0;
+    };
+
+    std::vector<entry> entries;
+
+    auto enabled() const -> bool { return !entries.empty(); }
+
+    // Uses the largest power of two entries which is no more than max_entries
+    void resize(std::size_t max_entries)
+    {
+        std::size_t size = 1;
+        while (size * 2 <= max_entries) {
+            size *= 2;
+        }
+        if (size != entries.size()) {
+            entries.assign(size, entry{});
+        }
+    }
+
+    // Zero marks an empty slot, so make sure no real key is zero
+    static auto key_of(std::uint64_t hash) -> std::uint64_t { return hash | 1; }
+
+    auto find(std::uint64_t hash) const -> const entry*
+    {
+        const auto& e = entries[hash & (entries.size() - 1)];
+        return e.key == key_of(hash) ? &e : nullptr;
+    }
+
+    void store(std::uint64_t hash, std::uint64_t solutions)
+    {
+        entries[hash & (entries.size() - 1)] = {key_of(hash), solutions};
+    }
+};
+
+// The knobs which change how a search_t explores the tree
+struct search_config {
+    solver_backend backend = solver_backend::search;
+    bool backjumping = false;
+    propagation_level propagation = propagation_level::singles;
+    branching_rule branching = branching_rule::mrv;
+    value_order values = value_order::ascending;
+    bool random_ties = false;
+    std::uint64_t seed = 0;
+    restart_policy restarts = restart_policy::none;
+    std::uint64_t restart_base = 0;
+    std::size_t table_size = 0;
+};
+
+auto make_config(const solve_options& options) -> search_config
+{
+    search_config config;
+    config.backend = options.backend;
+    config.backjumping = options.backjumping;
+    config.propagation = options.propagation;
+    config.branching = options.branching;
+    config.values = options.values;
+    config.random_ties = options.random_ties;
+    config.seed = options.seed;
+    config.restarts = options.restarts;
+    config.restart_base = std::max<std::uint64_t>(options.restart_base, 1);
+    config.table_size = options.transposition_table_size;
+    return config;
+}
+
+// Branching policies for basic_search. A policy's rule() says which branching
+// rule to use for a given config; if it always returns the same thing, the
+// compiler can throw away the code for the others.
+struct runtime_branching {
+    static auto rule(const search_config& config) -> branching_rule
+    {
+        return config.branching;
+    }
+};
+
+template <branching_rule Rule>
+struct fixed_branching {
+    static constexpr auto rule(const search_config&) -> branching_rule
+    {
+        return Rule;
+    }
+};
+
+// A depth-first search over the possible values of the unknown cells.
+// The state is kept in an explicit, fixed-size stack rather than on the call
+// stack, so that a search can be paused between solutions, and so that the
+// memory can be reused from one solve to the next without allocating.
+template <typename Policy>
+struct basic_search {
+    // Each frame is a (propagated) puzzle and what we are guessing in it:
+    // normally the value of a cell, in which case `untried` holds the
+    // values we haven't tried yet. If `unit` is not negative, we are instead
+    // guessing where `digit` goes in that unit, and `untried` holds the
+    // positions in the unit (counting from 1) we haven't tried yet.
+    // If the transposition table is in use, each frame also has the hash of
+    // its puzzle, and counts the solutions found below it.
+    struct frame {
+        puzzle_t puzzle;
+        int index;
+        int unit;
+        int digit;
+        std::uint16_t untried;
+        std::uint64_t hash;
+        std::uint64_t solutions;
+    };
+
+    // Every guess fixes at least one more cell, so we need at most one frame
+    // per unknown cell, plus one for the solution
+    std::array<frame, 82> stack;
+    int depth = 0;
+    solve_stats stats{};
+    search_config config{};
+    random_t random{};
+    transposition_table table;
+    // If non-zero, next() gives up once stats.guesses reaches this
+    std::uint64_t guess_limit = 0;
+    // If this is set, the search gives up as soon as it becomes true
+    const std::atomic<bool>* cancelled = nullptr;
+
+    void start(const puzzle_t& p)
+    {
+        stats = {};
+        random.state = config.seed;
+        guess_limit = 0;
+        if (config.table_size > 0) {
+            table.resize(config.table_size);
+        }
+        restart(p);
+    }
+
+    // Like start(), but carries on counting from where we were (and keeps
+    // what's in the transposition table, so we don't repeat dead ends)
+    void restart(const puzzle_t& p)
+    {
+        stack[0].puzzle = p;
+        if (!deduce(stack[0].puzzle, config.propagation)) {
+            depth = 0;
+            return;
+        }
+        stack[0].hash = use_table() ? zobrist_hash(stack[0].puzzle) : 0;
+        stack[0].solutions = 0;
+        push_frame(stack[0]);
+        depth = 1;
+    }
+
+    auto use_table() const -> bool { return config.table_size > 0 && table.enabled(); }
+
+    // True if next() returned because it had searched the whole tree (rather
+    // than because it was cancelled or hit the guess limit)
+    auto exhausted() const -> bool { return depth == 0; }
+
+    // Decides what to branch on in a newly-propagated puzzle
+    void push_frame(frame& f)
+    {
+        f.unit = -1;
+        switch (Policy::rule(config)) {
+        case branching_rule::units:
+            f.index = select_cell_by_degree(f.puzzle);
+            if (f.index >= 0 && select_unit(f)) {
+                return;
+            }
+            break;
+        case branching_rule::mrv_degree:
+            f.index = select_cell_by_degree(f.puzzle);
+            break;
+        case branching_rule::mrv:
+        default:
+            f.index = config.random_ties ? select_random_cell(f.puzzle) : select_cell(f.puzzle);
+            break;
+        }
+        f.untried = f.index < 0 ? 0 : f.puzzle[f.index].candidates();
+    }
+
+    // Like select_cell(), but chooses uniformly between the cells with the
+    // fewest possibilities
+    auto select_random_cell(const puzzle_t& p) -> int
+    {
+        int best = -1;
+        unsigned best_count = 10;
+        std::uint32_t num_ties = 0;
+        for (int i = 0; i < 81; i++) {
+            const unsigned count = p[i].count();
+            if (count == 1 || count > best_count) {
+                continue;
+            }
+            if (count < best_count) {
+                best = i;
+                best_count = count;
+                num_ties = 1;
+            } else if (config.random_ties && random.below(++num_ties) == 0) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // Returns the number of unknown peers of a cell
+    static auto degree(const puzzle_t& p, int index) -> int
+    {
+        int n = 0;
+        for (int peer : get_peers(index)) {
+            n += p[peer].count() > 1;
+        }
+        return n;
+    }
+
+    // Chooses between the cells with the fewest possibilities by taking the
+    // one with the most unknown peers, since guessing it tells us the most
+    auto select_cell_by_degree(const puzzle_t& p) -> int
+    {
+        int best = -1;
+        unsigned best_count = 10;
+        int best_degree = -1;
+        std::uint32_t num_ties = 0;
+        for (int i = 0; i < 81; i++) {
+            const unsigned count = p[i].count();
+            if (count == 1 || count > best_count) {
+                continue;
+            }
+            const int deg = degree(p, i);
+            if (count < best_count || deg > best_degree) {
+                best = i;
+                best_count = count;
+                best_degree = deg;
+                num_ties = 1;
+            } else if (deg == best_degree && config.random_ties &&
+                       random.below(++num_ties) == 0) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // Looks for a digit which has fewer possible places in some unit than
+    // the chosen cell has possible values. If there is one, sets up the frame
+    // to branch on the places for that digit, and returns true.
+    auto select_unit(frame& f) -> bool
+    {
+        const auto& p = f.puzzle;
+        auto best_places = p[f.index].count();
+        if (best_places <= 2) {
+            return false;
+        }
+
+        for (int u = 0; u < 27; u++) {
+            std::array<std::uint16_t, 9> places{};
+            std::uint16_t placed = 0;
+            for (int pos = 0; pos < 9; pos++) {
+                const auto& cell = p[unit_indices[u][pos]];
+                if (cell.count() == 1) {
+                    placed |= cell.candidates();
+                    continue;
+                }
+                for (int d = 1; d < 10; d++) {
+                    if (cell.could_be(d)) {
+                        places[d - 1] |= 1u << pos;
+                    }
+                }
+            }
+            for (int d = 1; d < 10; d++) {
+                const auto n = cell_t{places[d - 1]}.count();
+                if ((placed & (1u << (d - 1))) == 0 && n > 0 && n < best_places) {
+                    best_places = n;
+                    f.unit = u;
+                    f.digit = d;
+                    f.untried = places[d - 1];
+                }
+            }
+        }
+        return f.unit >= 0;
+    }
+
+    // Returns the number of unknown peers of the cell which could also be d;
+    // trying the digit with the lowest score first leaves the most options
+    // open for the rest of the puzzle
+    static auto constraint(const puzzle_t& p, int index, int d) -> int
+    {
+        int n = 0;
+        for (int peer : get_peers(index)) {
+            n += p[peer].count() > 1 && p[peer].could_be(d);
+        }
+        return n;
+    }
+
+    // Chooses the next value (or position, for a unit frame) to try
+    auto pick_value(const frame& f) -> int
+    {
+        switch (config.values) {
+        case value_order::descending:
+            return highest_digit(f.untried);
+        case value_order::random: {
+            auto mask = f.untried;
+            for (auto n = random.below(cell_t{mask}.count()); n > 0; n--) {
+                mask &= mask - 1;
+            }
+            return lowest_digit(mask);
+        }
+        case value_order::least_constraining:
+            if (f.unit < 0) {
+                int best = 0;
+                int best_score = 100;
+                for (auto mask = f.untried; mask != 0; mask &= mask - 1) {
+                    const int d = lowest_digit(mask);
+                    const int score = constraint(f.puzzle, f.index, d);
+                    if (score < best_score) {
+                        best = d;
+                        best_score = score;
+                    }
+                }
+                return best;
+            }
+            return lowest_digit(f.untried);
+        case value_order::ascending:
+        default:
+            return lowest_digit(f.untried);
+        }
+    }
+
+    // Continues the search until the next solution is found, and returns a
+    // pointer to it (valid until the next call), or nullptr if there are no
+    // more solutions
+    auto next() -> const puzzle_t*
+    {
+        while (depth > 0) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                return nullptr;
+            }
+
+            auto& top = stack[depth - 1];
+
+            if (top.index < 0) {
+                // Every cell is known, so this is a solution
+                pop_solution();
+                return &top.puzzle;
+            }
+
+            if (top.untried == 0) {
+                // We've tried every alternative for this frame
+                pop_exhausted();
+                continue;
+            }
+
+            if (guess_limit != 0 && stats.guesses >= guess_limit) {
+                return nullptr;
+            }
+
+            expand(top, false);
+        }
+        return nullptr;
+    }
+
+    // Tries the next alternative for the top frame in a new copy of the
+    // puzzle. If the assignment generated no contradictions (and the
+    // transposition table doesn't tell us all we need to know about the
+    // result), pushes it onto the stack and returns true.
+    auto expand(frame& top, bool counting) -> bool
+    {
+        const int value = pick_value(top);
+        top.untried &= ~(1u << (value - 1));
+        const int index = top.unit < 0 ? top.index : unit_indices[top.unit][value - 1];
+        const int digit = top.unit < 0 ? value : top.digit;
+        auto& child = stack[depth];
+        child.puzzle = top.puzzle;
+        ++stats.guesses;
+        if (!assign(child.puzzle, index, digit) ||
+            !deduce(child.puzzle, config.propagation)) {
+            return false;
+        }
+
+        if (use_table()) {
+            child.hash = zobrist_update(top.hash, top.puzzle, child.puzzle);
+            if (const auto* e = table.find(child.hash)) {
+                // We can always skip dead ends; if we're only counting, we
+                // can skip anything else we've seen before too
+                if (e->solutions == 0 || counting) {
+                    ++stats.table_hits;
+                    top.solutions += e->solutions;
+                    return false;
+                }
+            }
+        }
+        child.solutions = 0;
+        push_frame(child);
+        ++depth;
+        return true;
+    }
+
+    void pop_solution()
+    {
+        if (--depth > 0) {
+            ++stack[depth - 1].solutions;
+        }
+    }
+
+    // Pops a frame whose subtree has been completely explored, recording
+    // how many solutions it had
+    void pop_exhausted()
+    {
+        const auto& top = stack[depth - 1];
+        if (use_table()) {
+            table.store(top.hash, top.solutions);
+        }
+        ++stats.backtracks;
+        if (--depth > 0) {
+            stack[depth - 1].solutions += top.solutions;
+        }
+    }
+
+    // Counts the solutions of p, stopping once we've found max_count
+    auto count(const puzzle_t& p, std::uint64_t max_count) -> std::uint64_t
+    {
+        start(p);
+        if (depth > 0 && use_table()) {
+            if (const auto* e = table.find(stack[0].hash)) {
+                ++stats.table_hits;
+                return std::min(e->solutions, max_count);
+            }
+        }
+
+        std::uint64_t found = 0;
+        while (depth > 0 && found < max_count) {
+            auto& top = stack[depth - 1];
+            if (top.index < 0) {
+                ++found;
+                pop_solution();
+            } else if (top.untried == 0) {
+                pop_exhausted();
+            } else {
+                const auto before = top.solutions;
+                if (!expand(top, true)) {
+                    found += top.solutions - before;
+                }
+            }
+        }
+        return std::min(found, max_count);
+    }
+
+    // Searches for the first solution of p, restarting the search from
+    // scratch whenever it runs out of guesses if config.restarts says so.
+    // Since the limits keep growing, the search is still complete.
+    auto solve(const puzzle_t& p) -> const puzzle_t*
+    {
+        start(p);
+        if (config.restarts == restart_policy::none) {
+            return next();
+        }
+
+        std::uint64_t limit = config.restart_base;
+        for (std::uint64_t run = 1; ; run++) {
+            if (config.restarts == restart_policy::luby) {
+                limit = detail::luby(run) * config.restart_base;
+            }
+            guess_limit = stats.guesses + limit;
+
+            const auto soln = next();
+            if (soln || exhausted() ||
+                (cancelled && cancelled->load(std::memory_order_relaxed))) {
+                return soln;
+            }
+
+            if (config.restarts == restart_policy::geometric) {
+                limit += limit / 2 + 1;
+            }
+            ++stats.restarts;
+            restart(p);
+        }
+    }
+};
+
+// The branching rule can be fixed when the library is built (see the
+// TCB_SUDOKU_BRANCHING CMake option), in which case solve_options::branching
+// is ignored
+#ifdef TCB_SUDOKU_BRANCHING
+using search_t = basic_search<fixed_branching<branching_rule::TCB_SUDOKU_BRANCHING>>;
+#else
+using search_t = basic_search<runtime_branching>;
+#endif
+
+// A set of decision levels, as a bitmask. Decisions are numbered from 1 (the
+// first guess); the givens and anything deduced from them alone have no
+// decision to blame, so they don't appear at all.
+struct levels_t {
+    std::array<std::uint64_t, 2> bits{};
+
+    void add(int level) { bits[level / 64] |= std::uint64_t{1} << (level % 64); }
+
+    void remove(int level) { bits[level / 64] &= ~(std::uint64_t{1} << (level % 64)); }
+
+    auto empty() const -> bool { return bits[0] == 0 && bits[1] == 0; }
+
+    auto count() const -> int
+    {
+        return static_cast<int>(std::bitset<64>(bits[0]).count() +
+                                std::bitset<64>(bits[1]).count());
+    }
+
+    // Returns the latest decision in the set, or 0 if it is empty
+    auto highest() const -> int
+    {
+        for (int level = 127; level > 0; level--) {
+            if (bits[level / 64] & (std::uint64_t{1} << (level % 64))) {
+                return level;
+            }
+        }
+        return 0;
+    }
+
+    auto operator|=(const levels_t& other) -> levels_t&
+    {
+        bits[0] |= other.bits[0];
+        bits[1] |= other.bits[1];
+        return *this;
+    }
+};
+
+// A search with conflict-directed backjumping. Propagation (singles only)
+// records, for every eliminated candidate, the set of decisions which caused
+// it. When every value of a cell has failed, the union of the reasons is the
+// set of earlier decisions to blame, so rather than undoing just the last
+// guess we can jump straight back to the latest decision in that set. Small
+// sets of decisions found to be contradictory are remembered as "nogoods",
+// which rule out values early for the rest of the solve.
+struct backjump_search {
+    struct frame {
+        puzzle_t puzzle;
+        int index;
+        // The value the child frame is exploring
+        int value;
+        std::uint16_t untried;
+        // The decisions to blame for the values which have failed so far
+        levels_t conflict;
+    };
+
+    // A combination of (cell, value) decisions which can't all be true
+    struct nogood {
+        int size;
+        std::array<std::pair<std::int8_t, std::int8_t>, 4> cells;
+    };
+
+    // The decision made from stack[n] is decision number n + 1
+    std::array<frame, 82> stack;
+    int depth = 0;
+    // The reason each candidate was eliminated. Since a candidate is never
+    // eliminated twice on the way down the stack, the entries for candidates
+    // which are eliminated in a given frame stay valid while it is on the
+    // stack, so one table does for all of them.
+    std::array<std::array<levels_t, 9>, 81> why;
+    // The reason for the last contradiction found by propagation
+    levels_t conflict;
+    std::array<nogood, 256> nogoods;
+    int num_nogoods = 0;
+    int next_nogood = 0;
+    solve_stats stats{};
+    const std::atomic<bool>* cancelled = nullptr;
+
+    // The decisions to blame for a cell's value being restricted to `value`
+    // (or for it having no values at all, if value is 0)
+    auto cell_reason(const puzzle_t& p, int index, int value = 0) const -> levels_t
+    {
+        levels_t reason;
+        for (int d = 1; d < 10; d++) {
+            if (d != value && !p[index].could_be(d)) {
+                reason |= why[index][d - 1];
+            }
+        }
+        return reason;
+    }
+
+    // The decisions to blame for `value` being ruled out of every cell in
+    // a unit except `except`
+    auto unit_reason(int u, int value, int except = -1) const -> levels_t
+    {
+        levels_t reason;
+        for (int idx : unit_indices[u]) {
+            if (idx != except) {
+                reason |= why[idx][value - 1];
+            }
+        }
+        return reason;
+    }
+
+    // These follow assign() and eliminate() above, but remember why things
+    // happened, and set `conflict` when they fail
+    auto assign(puzzle_t& p, int index, int value, const levels_t& reason) -> bool
+    {
+        for (int d = 1; d < 10; d++) {
+            if (d != value && !eliminate(p, index, d, reason)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto eliminate(puzzle_t& p, int index, int value, const levels_t& reason) -> bool
+    {
+        auto& cell = p[index];
+        if (!cell.could_be(value)) {
+            return true;
+        }
+
+        cell.remove(value);
+        why[index][value - 1] = reason;
+        if (cell.count() == 0) {
+            conflict = cell_reason(p, index);
+            return false;
+        }
+        if (cell.count() == 1) {
+            const auto d = cell.get_value();
+            const auto r = cell_reason(p, index, d);
+            for (int peer : get_peers(index)) {
+                if (!eliminate(p, peer, d, r)) {
+                    return false;
+                }
+            }
+        }
+
+        for (int u : units_of(index)) {
+            int num_places = 0;
+            int place = -1;
+            for (int idx : unit_indices[u]) {
+                if (p[idx].could_be(value)) {
+                    ++num_places;
+                    place = idx;
+                }
+            }
+            if (num_places == 0) {
+                conflict = unit_reason(u, value);
+                return false;
+            }
+            if (num_places == 1 && !assign(p, place, value, unit_reason(u, value, place))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void start(const puzzle_t& p)
+    {
+        stats = {};
+        num_nogoods = 0;
+        next_nogood = 0;
+        // Whatever has already been eliminated is down to the givens
+        for (auto& reasons : why) {
+            reasons.fill(levels_t{});
+        }
+        stack[0].puzzle = p;
+        push_frame(stack[0]);
+        depth = 1;
+    }
+
+    auto exhausted() const -> bool { return depth == 0; }
+
+    void push_frame(frame& f)
+    {
+        f.index = select_cell(f.puzzle);
+        f.conflict = {};
+        f.untried = f.index < 0 ? 0 : f.puzzle[f.index].candidates();
+    }
+
+    // If all but one of the decisions in a nogood hold, the last one can't,
+    // so we can eliminate it (blaming whatever caused the others). Keeps
+    // going until no nogood applies; returns false (setting `conflict`) if
+    // the puzzle turns out to contain a complete nogood.
+    auto apply_nogoods(puzzle_t& p) -> bool
+    {
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (int n = 0; n < num_nogoods; n++) {
+                const auto& ng = nogoods[n];
+                int open = -1;
+                bool satisfied = false;
+                levels_t reason;
+                for (int i = 0; i < ng.size && !satisfied; i++) {
+                    const auto& cell = p[ng.cells[i].first];
+                    const int d = ng.cells[i].second;
+                    if (!cell.could_be(d)) {
+                        satisfied = true;
+                    } else if (cell.count() == 1) {
+                        reason |= cell_reason(p, ng.cells[i].first, d);
+                    } else if (open < 0) {
+                        open = i;
+                    } else {
+                        // At least two decisions are still undecided
+                        satisfied = true;
+                    }
+                }
+                if (satisfied) {
+                    continue;
+                }
+                if (open < 0) {
+                    conflict = reason;
+                    return false;
+                }
+                if (!eliminate(p, ng.cells[open].first, ng.cells[open].second, reason)) {
+                    return false;
+                }
+                progress = true;
+            }
+        }
+        return true;
+    }
+
+    void add_nogood(const levels_t& decisions)
+    {
+        nogood ng{};
+        for (int level = 1; level <= depth; level++) {
+            if (decisions.bits[level / 64] & (std::uint64_t{1} << (level % 64))) {
+                const auto& f = stack[level - 1];
+                ng.cells[ng.size++] = {static_cast<std::int8_t>(f.index),
+                                       static_cast<std::int8_t>(f.value)};
+            }
+        }
+        nogoods[next_nogood] = ng;
+        next_nogood = (next_nogood + 1) % static_cast<int>(nogoods.size());
+        num_nogoods = std::min(num_nogoods + 1, static_cast<int>(nogoods.size()));
+    }
+
+    auto next() -> const puzzle_t*
+    {
+        while (depth > 0) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                return nullptr;
+            }
+
+            auto& top = stack[depth - 1];
+
+            if (top.index < 0) {
+                --depth;
+                return &top.puzzle;
+            }
+
+            if (top.untried == 0) {
+                // Every value for this cell has failed. Work out which
+                // earlier decisions were responsible, and go back to the
+                // latest of them, skipping any in between.
+                auto blame = top.conflict;
+                blame |= cell_reason(top.puzzle, top.index);
+                ++stats.backtracks;
+
+                const int target = blame.highest();
+                if (target == 0) {
+                    // Nobody to blame but the givens
+                    depth = 0;
+                    return nullptr;
+                }
+                if (blame.count() <= static_cast<int>(nogood{}.cells.size())) {
+                    add_nogood(blame);
+                }
+                stats.backjumps += static_cast<std::uint64_t>(depth - target);
+                blame.remove(target);
+                depth = target;
+                stack[depth - 1].conflict |= blame;
+                continue;
+            }
+
+            const int value = lowest_digit(top.untried);
+            top.untried &= ~(1u << (value - 1));
+            top.value = value;
+
+            const int level = depth;
+            levels_t reason;
+            reason.add(level);
+            auto& child = stack[depth];
+            child.puzzle = top.puzzle;
+            ++stats.guesses;
+            if (assign(child.puzzle, top.index, value, reason) &&
+                apply_nogoods(child.puzzle)) {
+                push_frame(child);
+                ++depth;
+            } else {
+                conflict.remove(level);
+                top.conflict |= conflict;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Holds one of each kind of search, and runs whichever a config asks for.
+// The SAT solver is fairly big, so it's only created when it's first needed.
+struct searcher {
+    enum class engine { search, backjump, sat };
+
+    search_t search;
+    backjump_search backjump;
+    std::unique_ptr<detail::sat_solver> sat;
+    puzzle_t sat_solution;
+    engine used = engine::search;
+    const std::atomic<bool>* cancelled = nullptr;
+
+    void set_cancelled(const std::atomic<bool>* flag)
+    {
+        cancelled = flag;
+        search.cancelled = flag;
+        backjump.cancelled = flag;
+    }
+
+    auto solve(const puzzle_t& p, const search_config& config) -> const puzzle_t*
+    {
+        if (config.backend == solver_backend::sat) {
+            used = engine::sat;
+            return solve_sat(p);
+        }
+        if (config.backjumping) {
+            used = engine::backjump;
+            backjump.start(p);
+            return backjump.next();
+        }
+        used = engine::search;
+        search.config = config;
+        return search.solve(p);
+    }
+
+    // Counting always uses the normal search, whatever the backend
+    auto count(const puzzle_t& p, const search_config& config,
+               std::uint64_t max_count) -> std::uint64_t
+    {
+        used = engine::search;
+        search.config = config;
+        return search.count(p, max_count);
+    }
+
+    auto solve_sat(const puzzle_t& p) -> const puzzle_t*
+    {
+        if (!sat) {
+            sat = std::make_unique<detail::sat_solver>();
+        }
+        sat->cancelled = cancelled;
+
+        detail::candidates_t candidates;
+        std::array<std::uint8_t, 81> digits;
+        rng::transform(p, rng::begin(candidates), [](const cell_t& c) {
+            return c.candidates();
+        });
+        if (!sat->solve(candidates, digits)) {
+            return nullptr;
+        }
+        rng::transform(digits, rng::begin(sat_solution), [](std::uint8_t d) {
+            return cell_t{static_cast<std::uint16_t>(1u << (d - 1))};
+        });
+        return &sat_solution;
+    }
+
+    auto exhausted() const -> bool
+    {
+        switch (used) {
+        case engine::sat:
+            return sat->finished();
+        case engine::backjump:
+            return backjump.exhausted();
+        case engine::search:
+        default:
+            return search.exhausted();
+        }
+    }
+
+    auto stats() const -> solve_stats
+    {
+        switch (used) {
+        case engine::sat:
+            return sat->stats();
+        case engine::backjump:
+            return backjump.stats;
+        case engine::search:
+        default:
+            return search.stats;
+        }
+    }
+};
+
+auto run_search(searcher& s, const puzzle_t& p,
+                const search_config& config = {}) -> std::optional<grid>
+{
+    if (const auto soln = s.solve(p, config)) {
+        return puzzle_to_grid(*soln);
+    }
+    return std::nullopt;
+}
+
+// The search used by the free solve() functions. Each thread keeps one around
+// so that (after the first time) solving never needs to allocate.
+auto thread_search() -> searcher&
+{
+    thread_local auto search = std::make_unique<searcher>();
+    return *search;
+}
+
+// A piece of work for race_searches(): a puzzle, and how to search it
+struct search_job {
+    puzzle_t puzzle;
+    search_config config;
+};
+
+// Shares the jobs out between the calling thread and the pool's workers, and
+// returns the first solution that any of them finds, cancelling the rest.
+// If `each_job_complete` is true then every job is a search of the whole
+// problem, so the first one to come up empty means there is no solution;
+// otherwise we have to wait for all of them.
+auto race_searches(std::vector<search_job> jobs, bool each_job_complete,
+                   worker_pool& pool) -> std::optional<grid>
+{
+    if (jobs.empty()) {
+        return std::nullopt;
+    }
+
+    // Workers may still be running (about to notice that they've been
+    // cancelled) after we return, so they share ownership of the state
+    struct state_t {
+        std::vector<search_job> jobs;
+        bool each_job_complete;
+        std::atomic<std::size_t> next_job{0};
+        std::atomic<bool> done{false};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t num_finished = 0;
+        std::optional<grid> result;
+    };
+    auto state = std::make_shared<state_t>();
+    state->jobs = std::move(jobs);
+    state->each_job_complete = each_job_complete;
+
+    auto worker = [state] {
+        auto search = std::make_unique<searcher>();
+        search->set_cancelled(&state->done);
+
+        while (!state->done) {
+            const auto i = state->next_job++;
+            if (i >= state->jobs.size()) {
+                break;
+            }
+
+            const auto& job = state->jobs[i];
+            const auto soln = search->solve(job.puzzle, job.config);
+            const bool exhausted = search->exhausted();
+
+            std::lock_guard<std::mutex> lock{state->mutex};
+            if (!state->done) {
+                if (soln) {
+                    state->result = puzzle_to_grid(*soln);
+                    state->done = true;
+                } else if (exhausted && state->each_job_complete) {
+                    state->done = true;
+                }
+            }
+            ++state->num_finished;
+            state->cv.notify_all();
+        }
+    };
+
+    // The calling thread does its share too, so even if none of the pool's
+    // threads are free (or we're running on one of them) we'll still finish
+    const auto num_helpers = std::min<std::size_t>(pool.size(), state->jobs.size() - 1);
+    for (std::size_t i = 0; i < num_helpers; i++) {
+        pool.post(worker);
+    }
+    worker();
+
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->cv.wait(lock, [&] {
+        return state->done || state->num_finished == state->jobs.size();
+    });
+    return std::move(state->result);
+}
+
+// Speculative parallel search. The first `depth` levels of the search tree
+// are expanded up front, and the resulting subproblems are raced against
+// each other.
+auto parallel_search(const puzzle_t& root, int depth, const search_config& config,
+                     worker_pool& pool) -> std::optional<grid>
+{
+    std::vector<puzzle_t> frontier{root};
+    for (int level = 0; level < depth && !frontier.empty(); level++) {
+        std::vector<puzzle_t> next;
+        for (const auto& p : frontier) {
+            const auto idx = select_cell(p);
+            if (idx < 0) {
+                // This one is already solved
+                return puzzle_to_grid(p);
+            }
+            for (int i = 1; i < 10; i++) {
+                if (!p[idx].could_be(i)) {
+                    continue;
+                }
+                auto p_copy = p;
+                if (assign(p_copy, idx, i)) {
+                    next.push_back(p_copy);
+                }
+            }
+        }
+        frontier = std::move(next);
+    }
+
+    std::vector<search_job> jobs;
+    jobs.reserve(frontier.size());
+    for (const auto& p : frontier) {
+        jobs.push_back({p, config});
+    }
+    return race_searches(std::move(jobs), false, pool);
+}
+
+// Portfolio search: every variant searches the whole tree in its own way,
+// and the first to finish wins
+auto portfolio_search(const puzzle_t& root, const std::vector<solve_options>& variants,
+                      worker_pool& pool) -> std::optional<grid>
+{
+    std::vector<search_job> jobs;
+    jobs.reserve(variants.size());
+    for (const auto& v : variants) {
+        jobs.push_back({root, make_config(v)});
+    }
+    return race_searches(std::move(jobs), true, pool);
+}
+
+}
+
+struct solver::impl {
+    searcher search;
+    solve_stats stats{};
+};
+
+solver::solver()
+    : impl_(std::make_unique<impl>())
+{}
+
+solver::solver(solver&&) noexcept = default;
+
+solver& solver::operator=(solver&&) noexcept = default;
+
+solver::~solver() = default;
+
+auto solver::solve(const grid& grid_) -> std::optional<grid>
+{
+    return solve(grid_, solve_options{});
+}
+
+auto solver::solve(const grid& grid_, const solve_options& options) -> std::optional<grid>
+{
+    auto puzzle = grid_to_puzzle(grid_);
+    if (!puzzle) {
+        impl_->stats = {};
+        return std::nullopt;
+    }
+    auto result = run_search(impl_->search, *puzzle, make_config(options));
+    impl_->stats = impl_->search.stats();
+    return result;
+}
+
+auto solver::count_solutions(const grid& grid_, std::uint64_t max_count,
+                             const solve_options& options) -> std::uint64_t
+{
+    auto puzzle = grid_to_puzzle(grid_);
+    if (!puzzle) {
+        impl_->stats = {};
+        return 0;
+    }
+    const auto count = impl_->search.count(*puzzle, make_config(options), max_count);
+    impl_->stats = impl_->search.stats();
+    return count;
+}
+
+auto solver::stats() const -> solve_stats
+{
+    return impl_->stats;
+}
+
+struct solution_enumerator::impl {
+    search_t search;
+};
+
+solution_enumerator::solution_enumerator(const grid& grid_)
+    : impl_(std::make_unique<impl>())
+{
+    if (auto puzzle = grid_to_puzzle(grid_)) {
+        impl_->search.start(*puzzle);
+    }
+}
+
+solution_enumerator::solution_enumerator(solution_enumerator&&) noexcept = default;
+
+solution_enumerator& solution_enumerator::operator=(solution_enumerator&&) noexcept = default;
+
+solution_enumerator::~solution_enumerator() = default;
+
+auto solution_enumerator::next() -> std::optional<grid>
+{
+    if (!impl_) {
+        return std::nullopt;
+    }
+    if (const auto soln = impl_->search.next()) {
+        return puzzle_to_grid(*soln);
+    }
+    return std::nullopt;
+}
+
+auto detail::solve_candidates(const candidates_t& candidates) -> std::optional<grid>
+{
+    auto puzzle = puzzle_t{};
+    rng::transform(candidates, rng::begin(puzzle), [] (std::uint16_t bits) {
+        return cell_t{bits};
+    });
+    return run_search(thread_search(), puzzle);
+}
+
+auto detail::luby(std::uint64_t i) -> std::uint64_t
+{
+    while (true) {
+        int k = 1;
+        while ((std::uint64_t{1} << k) - 1 < i) {
+            ++k;
+        }
+        if (i == (std::uint64_t{1} << k) - 1) {
+            return std::uint64_t{1} << (k - 1);
+        }
+        i -= (std::uint64_t{1} << (k - 1)) - 1;
+    }
+}
+
+auto solve(const grid& g) -> std::optional<grid>
+{
+    return solve(grid_view{g});
+}
+
+auto solve(grid_view g) -> std::optional<grid>
+{
+    auto puzzle = grid_to_puzzle(g);
+    if (!puzzle) {
+        return std::nullopt;
+    }
+    return run_search(thread_search(), *puzzle);
+}
+
+auto solve(const grid& g, const solve_options& options) -> std::optional<grid>
+{
+    auto puzzle = grid_to_puzzle(g);
+    if (!puzzle) {
+        return std::nullopt;
+    }
+
+    auto& pool = options.pool ? *options.pool : worker_pool::default_pool();
+    if (!options.portfolio.empty()) {
+        return portfolio_search(*puzzle, options.portfolio, pool);
+    }
+    if (options.parallel_depth > 0) {
+        return parallel_search(*puzzle, options.parallel_depth, make_config(options), pool);
+    }
+    return run_search(thread_search(), *puzzle, make_config(options));
+}
+
+auto validate(const grid& g) -> std::vector<int>
+{
+    return validate(grid_view{g});
+}
+
+auto validate(grid_view g) -> std::vector<int>
+{
+    std::vector<int> cells;
+    const auto repeated = scan_givens(g).repeated;
+    if (repeated.any()) {
+        for (int i = 0; i < 81; i++) {
+            if ((repeated.of(i) & digit_bit(g[i])) != 0) {
+                cells.push_back(i);
+            }
+        }
+    }
+    return cells;
+}
+
+auto count_solutions(const grid& g, std::uint64_t max_count,
+                     const solve_options& options) -> std::uint64_t
+{
+    auto puzzle = grid_to_puzzle(g);
+    if (!puzzle) {
+        return 0;
+    }
+    return thread_search().count(*puzzle, make_config(options), max_count);
+}
+
+auto default_portfolio(int size) -> std::vector<solve_options>
+{
+    // Each entry should explore the tree as differently as possible from
+    // the ones before it. After the deterministic variants, we add
+    // randomised solvers with restarts, each with its own seed.
+    std::vector<solve_options> variants;
+    for (int i = 0; i < size; i++) {
+        solve_options v;
+        if (i == 1) {
+            v.values = value_order::descending;
+        } else if (i == 2) {
+            v.branching = branching_rule::units;
+            v.values = value_order::least_constraining;
+        } else if (i == 3) {
+            v.backend = solver_backend::sat;
+        } else if (i > 3) {
+            v.values = value_order::random;
+            v.random_ties = true;
+            v.seed = static_cast<std::uint64_t>(i);
+            v.restarts = (i % 2 == 0) ? restart_policy::luby : restart_policy::geometric;
+        }
+        variants.push_back(std::move(v));
+    }
+    return variants;
 }
 
 }}
\ No newline at end of file
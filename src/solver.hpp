@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#ifndef TCB_SUDOKU_SOLVER_HPP
+#define TCB_SUDOKU_SOLVER_HPP
+
+#include <tcb/sudoku.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace tcb {
+namespace sudoku {
+namespace detail {
+
+// The possible values of each cell, as a bitmask where bit (n - 1) is set if
+// the cell could contain the digit n.
+using candidates_t = std::array<std::uint16_t, 81>;
+
+constexpr std::uint16_t all_candidates = 0b111'111'111;
+
+// Runs the normal search from a set of candidates which have already been
+// propagated as far as possible (that is, every known digit has been removed
+// from its peers, and every digit with only one possible place in a unit has
+// been placed there).
+auto solve_candidates(const candidates_t& candidates) -> std::optional<grid>;
+
+// The i'th term (counting from 1) of the Luby sequence 1,1,2,1,1,2,4,1,...,
+// which the search and the SAT solver both use to space out their restarts
+auto luby(std::uint64_t i) -> std::uint64_t;
+
+} // end namespace detail
+} // end namespace sudoku
+} // end namespace tcb
+
+#endif
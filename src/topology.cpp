@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#include <tcb/sudoku.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace tcb {
+namespace sudoku {
+
+namespace {
+
+// Parses a Linux-style list such as "0-3,8,10-11"
+auto parse_list(const std::string& str) -> std::vector<int>
+{
+    std::vector<int> out;
+    std::istringstream ss{str};
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+        std::istringstream rs{range};
+        if (!(rs >> first)) {
+            continue;
+        }
+        last = first;
+        if (rs >> dash >> last && dash != '-') {
+            continue;
+        }
+        for (int i = first; i <= last; i++) {
+            out.push_back(i);
+        }
+    }
+
+    return out;
+}
+
+auto read_list(const std::string& path) -> std::vector<int>
+{
+    std::ifstream file{path};
+    std::string line;
+    std::getline(file, line);
+    return parse_list(line);
+}
+
+}
+
+auto numa_topology() -> std::vector<numa_node>
+{
+    std::vector<numa_node> nodes;
+
+#ifdef __linux__
+    const std::string base = "/sys/devices/system/node/";
+    for (int id : read_list(base + "online")) {
+        auto cpus = read_list(base + "node" + std::to_string(id) + "/cpulist");
+        // Memory-only nodes are no use to us
+        if (!cpus.empty()) {
+            nodes.push_back({id, std::move(cpus)});
+        }
+    }
+#endif
+
+    if (nodes.empty()) {
+        const int num_cpus = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        numa_node node{0, {}};
+        for (int i = 0; i < num_cpus; i++) {
+            node.cpus.push_back(i);
+        }
+        nodes.push_back(std::move(node));
+    }
+
+    return nodes;
+}
+
+}
+}
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2017 Tristan Brindle <tcbrindle@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+
+#include <tcb/sudoku.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace tcb {
+namespace sudoku {
+
+namespace {
+
+// Pinning is strictly best-effort: if it fails (for example because the CPU
+// is not in our allowed set) the thread just runs wherever it's put
+void pin_this_thread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void) cpu;
+#endif
+}
+
+}
+
+struct worker_pool::impl {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    void run()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    // We only get here if we're stopping
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+worker_pool::worker_pool(unsigned num_threads)
+    : impl_(std::make_unique<impl>())
+{
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    impl_->threads.reserve(num_threads);
+    for (unsigned i = 0; i < num_threads; i++) {
+        impl_->threads.emplace_back([this] { impl_->run(); });
+    }
+}
+
+worker_pool::worker_pool(const std::vector<int>& cpus)
+    : impl_(std::make_unique<impl>())
+{
+    // A pool with no threads would never run anything posted to it
+    if (cpus.empty()) {
+        throw std::invalid_argument("worker_pool needs at least one CPU");
+    }
+
+    impl_->threads.reserve(cpus.size());
+    for (int cpu : cpus) {
+        impl_->threads.emplace_back([this, cpu] {
+            pin_this_thread(cpu);
+            impl_->run();
+        });
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock{impl_->mutex};
+        impl_->stopping = true;
+    }
+    impl_->cv.notify_all();
+    for (auto& t : impl_->threads) {
+        t.join();
+    }
+}
+
+auto worker_pool::size() const -> unsigned
+{
+    return static_cast<unsigned>(impl_->threads.size());
+}
+
+void worker_pool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock{impl_->mutex};
+        impl_->tasks.push_back(std::move(task));
+    }
+    impl_->cv.notify_one();
+}
+
+auto worker_pool::default_pool() -> worker_pool&
+{
+    static worker_pool pool;
+    return pool;
+}
+
+}
+}
@@ -0,0 +1,107 @@
+
+#include <tcb/sudoku.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <vector>
+
+// Count every allocation the program makes
+static std::atomic<long> num_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    ++num_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++num_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: test_allocations <puzzle file>...\n";
+        return 1;
+    }
+
+    std::vector<tcb::sudoku::grid> grids;
+    for (int i = 1; i < argc; i++) {
+        std::ifstream is{argv[i]};
+        while (auto grid = tcb::sudoku::grid::parse(is)) {
+            grids.push_back(*grid);
+        }
+    }
+    if (grids.empty()) {
+        std::cerr << "Error: could not read any puzzles\n";
+        return 1;
+    }
+
+    // Any options are fine, as long as they use the normal search backend.
+    // Backjumping ignores the other search options, so it gets a set of its
+    // own.
+    tcb::sudoku::solve_options options;
+    options.propagation = tcb::sudoku::propagation_level::x_wing;
+    options.branching = tcb::sudoku::branching_rule::units;
+    options.values = tcb::sudoku::value_order::least_constraining;
+    options.random_ties = true;
+    options.restarts = tcb::sudoku::restart_policy::luby;
+
+    tcb::sudoku::solve_options backjumping;
+    backjumping.backjumping = true;
+
+    // The transposition table is allocated by the first call which uses it,
+    // but after that it is reused as long as its size doesn't change
+    tcb::sudoku::solve_options table_options;
+    table_options.transposition_table_size = 1 << 12;
+
+    tcb::sudoku::solver solver;
+    (void) solver.count_solutions(grids.front(), 2, table_options);
+    // Make sure the free solve() has set up its thread-local state
+    (void) tcb::sudoku::solve(grids.front());
+
+    const long before = num_allocations;
+    for (const auto& grid : grids) {
+        if (!solver.solve(grid) || !tcb::sudoku::solve(grid) || !solver.solve(grid, options) ||
+            !solver.solve(grid, backjumping)) {
+            std::cerr << "Error: could not solve grid\n" << grid << std::endl;
+            return 1;
+        }
+        if (solver.count_solutions(grid, 2) != 1 ||
+            solver.count_solutions(grid, 2, table_options) != 1 ||
+            !solver.solve(grid, table_options)) {
+            std::cerr << "Error: could not count solutions of grid\n" << grid << std::endl;
+            return 1;
+        }
+    }
+    const long allocations = num_allocations - before;
+
+    if (allocations != 0) {
+        std::cerr << "Error: solving " << grids.size() << " puzzles made "
+                  << allocations << " allocations\n";
+        return 1;
+    }
+}
@@ -0,0 +1,73 @@
+#include <tcb/sudoku.hpp>
+#include "batch.hpp"
+
+#include "catch.hpp"
+
+#include <optional>
+#include <vector>
+
+// solve_batch() only ever uses one of the kernels (the best one the CPU
+// supports), so these call each of them directly
+
+namespace {
+
+// A mixture of grids which are solved by propagation alone, grids which
+// need a search, and grids with no solution. There are a prime number of
+// them, so the last batch is a partial one whatever the number of lanes.
+auto make_grids() -> std::vector<tcb::sudoku::grid>
+{
+    const char* const strs[] = {
+        "6.2.5.........3.4..........43...8....1....2........7..5..27...........81...6.....",
+        "682154379951763842374892165437528916816937254295416738568271493729345681143689527",
+        "68.15.37995176384237.89.165437528916816937254295416738568271493729345681143689527",
+        "111111111........................................................................",
+        "6.2.5.........3.4..........43...8....1....2........7..5..27...........81...6....9",
+        ".................................................................................",
+        "4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+    };
+
+    std::vector<tcb::sudoku::grid> grids;
+    for (int i = 0; i < 101; i++) {
+        grids.push_back(*tcb::sudoku::grid::parse(strs[i % 7]));
+    }
+    return grids;
+}
+
+void check_kernel(tcb::sudoku::detail::batch_kernel_t kernel)
+{
+    const auto grids = make_grids();
+    std::vector<std::optional<tcb::sudoku::grid>> solns(grids.size());
+    kernel(grids.data(), grids.size(), solns.data());
+    for (std::size_t i = 0; i < grids.size(); i++) {
+        REQUIRE(solns[i] == tcb::sudoku::solve(grids[i]));
+    }
+}
+
+}
+
+TEST_CASE("The generic batch kernel gives the same results as solve()", "[batch]")
+{
+    check_kernel(tcb::sudoku::detail::solve_batch_generic);
+}
+
+#ifdef TCB_SUDOKU_HAVE_X86_SIMD
+TEST_CASE("The AVX2 batch kernel gives the same results as solve()", "[batch]")
+{
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2")) {
+        WARN("AVX2 is not supported by this CPU");
+        return;
+    }
+    check_kernel(tcb::sudoku::detail::solve_batch_avx2);
+}
+
+TEST_CASE("The AVX-512 batch kernel gives the same results as solve()", "[batch]")
+{
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx512bw")) {
+        WARN("AVX-512 is not supported by this CPU");
+        return;
+    }
+    check_kernel(tcb::sudoku::detail::solve_batch_avx512);
+}
+#endif
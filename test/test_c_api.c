@@ -25,10 +25,39 @@ static const char solvable_printed[] =
         ". . . | . . . | . 8 1\n"
         ". . . | 6 . . | . . .";
 static const char empty[] = ".................................................................................";
-static const char empty_soln[] = "123456789456789123789123456231674895875912364694538217317265948542897631968341572";
 /*static const char unsolvable[] = ".....5.8....6.1.43..........1.5........1.6...3.......553.....61........4.........";*/
 static const char unsolvable[] = "111111111........................................................................";
 
+/* Returns non-zero if str is a complete grid, with each digit once in every
+ * row, column and box. Which solution of the empty grid is found depends on
+ * the branching rule the library was built with. */
+static int is_complete(const char *str)
+{
+    int unit = 0;
+    int i = 0;
+
+    for (i = 0; i < 81; i++) {
+        if (str[i] < '1' || str[i] > '9') {
+            return 0;
+        }
+    }
+    for (unit = 0; unit < 9; unit++) {
+        int rows = 0;
+        int columns = 0;
+        int boxes = 0;
+        for (i = 0; i < 9; i++) {
+            const int box_cell = (unit / 3) * 27 + (unit % 3) * 3 + (i / 3) * 9 + i % 3;
+            rows |= 1 << (str[unit * 9 + i] - '0');
+            columns |= 1 << (str[i * 9 + unit] - '0');
+            boxes |= 1 << (str[box_cell] - '0');
+        }
+        if (rows != 0x3fe || columns != 0x3fe || boxes != 0x3fe) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 static void test_parse_from_string(void)
 {
     SudokuGrid *grid = NULL;
@@ -83,7 +112,7 @@ static void test_empty_solve(void)
     soln = sudoku_solve(grid);
 
     assert(soln);
-    assert(strcmp(empty_soln, sudoku_grid_to_string(soln)) == 0);
+    assert(is_complete(sudoku_grid_to_string(soln)));
 
     sudoku_grid_free(grid);
     sudoku_grid_free(soln);
@@ -102,6 +131,79 @@ static void test_unsolvable(void)
     sudoku_grid_free(grid);
 }
 
+static void test_parse_from_file(void)
+{
+    FILE *file = NULL;
+    SudokuGrid *grid = NULL;
+    char rest[16];
+
+    file = tmpfile();
+    assert(file);
+    fprintf(file, "%s123\n%s\nend", solvable, solvable_printed);
+    rewind(file);
+
+    grid = sudoku_grid_fscan(file);
+    assert(grid);
+    assert(strcmp(sudoku_grid_to_string(grid), solvable) == 0);
+    sudoku_grid_free(grid);
+
+    /* The file is left just after the grid */
+    assert(fgets(rest, sizeof(rest), file));
+    assert(strcmp(rest, "123\n") == 0);
+
+    grid = sudoku_grid_fscan(file);
+    assert(grid);
+    assert(strcmp(sudoku_grid_to_string(grid), solvable) == 0);
+    sudoku_grid_free(grid);
+
+    grid = sudoku_grid_fscan(file);
+    assert(!grid);
+
+    fclose(file);
+}
+
+static void test_reader(void)
+{
+    FILE *file = NULL;
+    SudokuReader *reader = NULL;
+    SudokuGrid *grid = NULL;
+    char rest[16];
+    int i;
+
+    file = tmpfile();
+    assert(file);
+    for (i = 0; i < 1000; i++) {
+        fprintf(file, "%s\n%s\n", solvable, solvable_printed);
+    }
+    fprintf(file, "%s tail\n", empty);
+    rewind(file);
+
+    reader = sudoku_reader_new(file);
+    assert(reader);
+    for (i = 0; i < 2000; i++) {
+        grid = sudoku_reader_next(reader);
+        assert(grid);
+        assert(strcmp(sudoku_grid_to_string(grid), solvable) == 0);
+        sudoku_grid_free(grid);
+    }
+    grid = sudoku_reader_next(reader);
+    assert(grid);
+    assert(strcmp(sudoku_grid_to_string(grid), empty) == 0);
+    sudoku_grid_free(grid);
+
+    /* Freeing the reader gives back what it read ahead */
+    sudoku_reader_free(reader);
+    assert(fgets(rest, sizeof(rest), file));
+    assert(strcmp(rest, " tail\n") == 0);
+
+    reader = sudoku_reader_new(file);
+    assert(!sudoku_reader_next(reader));
+    assert(!sudoku_reader_next(reader));
+    sudoku_reader_free(reader);
+
+    fclose(file);
+}
+
 static void test_null(void)
 {
     SudokuGrid *grid = NULL;
@@ -119,6 +221,10 @@ static void test_null(void)
     grid = sudoku_grid_fscan(NULL);
     assert(!grid);
 
+    assert(!sudoku_reader_new(NULL));
+    assert(!sudoku_reader_next(NULL));
+    sudoku_reader_free(NULL);
+
     str = sudoku_grid_to_string(NULL);
     assert(!str);
 
@@ -136,6 +242,8 @@ int main(void)
     test_simple_solve();
     test_empty_solve();
     test_unsolvable();
+    test_parse_from_file();
+    test_reader();
     test_null();
 
     return 0;
@@ -0,0 +1,88 @@
+
+#include <tcb/sudoku.hpp>
+
+/* Make sure asserts fire, even in release builds */
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <string_view>
+#include <vector>
+
+#ifndef TCB_SUDOKU_HAVE_COROUTINES
+#error "Coroutine support was not detected"
+#endif
+
+constexpr std::string_view solvable = "6.2.5.........3.4..........43...8....1....2........7..5..27...........81...6.....";
+constexpr std::string_view solvable_soln = "682154379951763842374892165437528916816937254295416738568271493729345681143689527";
+constexpr std::string_view unsolvable = "111111111........................................................................";
+// A solved grid with four cells removed, leaving two ways to fill them in
+constexpr std::string_view two_solutions = "68.15.37995176384237.89.165437528916816937254295416738568271493729345681143689527";
+
+// A fire-and-forget coroutine type, just enough to be able to co_await
+struct detached {
+    struct promise_type {
+        detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+detached solve_and_report(tcb::sudoku::grid grid,
+                          std::promise<std::optional<tcb::sudoku::grid>>& out)
+{
+    auto soln = co_await tcb::sudoku::solve_task(grid);
+    out.set_value(std::move(soln));
+}
+
+static void test_solve_task()
+{
+    {
+        std::promise<std::optional<tcb::sudoku::grid>> p;
+        auto f = p.get_future();
+        solve_and_report(*tcb::sudoku::grid::parse(solvable), p);
+        const auto soln = f.get();
+        assert(soln);
+        assert(tcb::sudoku::to_string(*soln) == solvable_soln);
+    }
+    {
+        std::promise<std::optional<tcb::sudoku::grid>> p;
+        auto f = p.get_future();
+        solve_and_report(*tcb::sudoku::grid::parse(unsolvable), p);
+        assert(!f.get());
+    }
+}
+
+static void test_solutions_generator()
+{
+    std::vector<tcb::sudoku::grid> solns;
+    for (const auto& soln : tcb::sudoku::solutions(*tcb::sudoku::grid::parse(two_solutions))) {
+        solns.push_back(soln);
+    }
+    assert(solns.size() == 2);
+    assert(solns[0] != solns[1]);
+    assert(solns[0] == *tcb::sudoku::solve(*tcb::sudoku::grid::parse(two_solutions)));
+
+    for (const auto& soln : tcb::sudoku::solutions(*tcb::sudoku::grid::parse(unsolvable))) {
+        (void) soln;
+        assert(false);
+    }
+
+    // Stopping early must be fine
+    for (const auto& soln : tcb::sudoku::solutions(tcb::sudoku::grid{})) {
+        (void) soln;
+        break;
+    }
+}
+
+int main()
+{
+    test_solve_task();
+    test_solutions_generator();
+}
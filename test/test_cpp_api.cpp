@@ -5,6 +5,8 @@
 
 #include <map>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <unordered_map>
 
 constexpr auto& solvable = "6.2.5.........3.4..........43...8....1....2........7..5..27...........81...6.....";
@@ -28,12 +30,30 @@ constexpr auto& empty_soln = "12345678945678912378912345623167489587591236469453
 //constexpr auto& unsolvable = ".....5.8....6.1.43..........1.5........1.6...3.......553.....61........4.........";
 constexpr auto& unsolvable = "111111111........................................................................";
 
+// This is solvable_soln with a 2x2 "deadly pattern" removed, which means
+// the 2s and 4s can go either way round
+constexpr auto& two_solutions = "68.15.37995176384237.89.165437528916816937254295416738568271493729345681143689527";
+
 bool equal(std::string_view sv, const tcb::sudoku::grid& grid)
 {
     return std::equal(std::begin(sv), std::end(sv),
                       std::begin(grid), std::end(grid));
 }
 
+// Checks that soln is a complete grid, with no digit repeated in a row,
+// column or box, which keeps all the givens of puzzle. Which solution is found
+// for a puzzle with more than one depends on the branching rule (which can be
+// fixed when the library is built), so tests of such puzzles use this.
+bool solves(const tcb::sudoku::grid& puzzle, const tcb::sudoku::grid& soln)
+{
+    for (std::size_t i = 0; i < puzzle.size(); i++) {
+        if (soln[i] == '.' || (puzzle[i] != '.' && puzzle[i] != soln[i])) {
+            return false;
+        }
+    }
+    return tcb::sudoku::validate(soln).empty();
+}
+
 /*
  * Grid parsing tests
  */
@@ -62,6 +82,25 @@ TEST_CASE("Grids can be parsed from streams", "[parse]")
     }
 }
 
+TEST_CASE("Parsing a stream stops just after the last cell", "[parse]")
+{
+    std::stringstream ss;
+    ss << solvable << "123\n" << solvable_printed << " | end\n" << "1234";
+    REQUIRE(tcb::sudoku::grid::parse(ss) == tcb::sudoku::grid::parse(solvable));
+    REQUIRE(ss.good());
+    std::string rest;
+    std::getline(ss, rest);
+    REQUIRE(rest == "123");
+
+    REQUIRE(tcb::sudoku::grid::parse(ss) == tcb::sudoku::grid::parse(solvable));
+    std::getline(ss, rest);
+    REQUIRE(rest == " | end");
+
+    // Not enough cells left for another grid
+    REQUIRE_FALSE(tcb::sudoku::grid::parse(ss));
+    REQUIRE(ss.eof());
+}
+
 TEST_CASE("Nonsense strings do not get parsed", "[parse]")
 {
     const auto grid = tcb::sudoku::grid::parse("Some nonsense");
@@ -99,6 +138,26 @@ TEST_CASE("Zeros get parsed as dots in strings", "[parse]")
     REQUIRE(equal(solvable, *grid));
 }
 
+TEST_CASE("Other characters are skipped wherever they appear", "[parse]")
+{
+    // Each of these puts something which isn't a cell somewhere in the
+    // first 81 characters, including bytes with the top bit set
+    for (int pos : {0, 15, 16, 40, 79, 80}) {
+        for (char c : {'\xff', '\x80', '/', ':', ' ', '\n', 'a'}) {
+            auto str = std::string(solvable);
+            str.insert(str.begin() + pos, c);
+            const auto grid = tcb::sudoku::grid::parse(str);
+            REQUIRE(grid);
+            REQUIRE(equal(solvable, *grid));
+        }
+    }
+
+    // Anything after the first 81 cells is ignored
+    const auto grid = tcb::sudoku::grid::parse(std::string(solvable) + "123\xff");
+    REQUIRE(grid);
+    REQUIRE(equal(solvable, *grid));
+}
+
 TEST_CASE("Zeros get parsed as dots in streams", "[parse]")
 {
     auto str = std::string(solvable);
@@ -128,6 +187,17 @@ TEST_CASE("Grids can be printed to streams", "[grid]")
     REQUIRE(ss.str() == solvable_printed);
 }
 
+TEST_CASE("Grids can be formatted into a buffer", "[grid]")
+{
+    const auto grid = *tcb::sudoku::grid::parse(solvable);
+    auto buffer = std::string(tcb::sudoku::formatted_grid_size + 1, '#');
+    const auto end = tcb::sudoku::format_to(&buffer[0], grid);
+    REQUIRE(end == &buffer[tcb::sudoku::formatted_grid_size]);
+    REQUIRE(buffer.back() == '#');
+    buffer.pop_back();
+    REQUIRE(buffer == solvable_printed);
+}
+
 TEST_CASE("Grids can be round-tripped to streams", "[grid]")
 {
     const auto grid1 = *tcb::sudoku::grid::parse(solvable);
@@ -142,6 +212,79 @@ TEST_CASE("Grids can be round-tripped to streams", "[grid]")
  * Regular type tests
  */
 
+TEST_CASE("Grids can be packed and unpacked", "[grid]")
+{
+    for (const auto* str : {solvable, solvable_soln, empty, empty_soln, unsolvable}) {
+        const auto grid = *tcb::sudoku::grid::parse(str);
+        const auto packed = grid.pack();
+        REQUIRE(tcb::sudoku::grid::unpack(packed) == grid);
+    }
+
+    const auto packed = tcb::sudoku::grid::parse(solvable)->pack();
+    REQUIRE(packed[0] == 0x06);
+    REQUIRE(packed[1] == 0x02);
+    REQUIRE(packed[2] == 0x05);
+    REQUIRE(packed[40] == 0x00);
+
+    // Nibbles above 9 aren't cells
+    for (std::size_t i : {0, 7, 39, 40}) {
+        auto bad = packed;
+        bad[i] = 0xa0;
+        REQUIRE_FALSE(tcb::sudoku::grid::unpack(bad));
+    }
+}
+
+TEST_CASE("Packed corpora can be written and read", "[grid]")
+{
+    std::vector<tcb::sudoku::packed_grid> grids;
+    for (int i = 0; i < 70000; i++) {
+        grids.push_back(tcb::sudoku::grid::parse(i % 2 ? solvable : empty_soln)->pack());
+    }
+
+    std::stringstream ss;
+    tcb::sudoku::write_packed_corpus(ss, grids);
+    REQUIRE(ss.str().size() == 16 + 41 * grids.size());
+    REQUIRE(ss.str().substr(0, 8) == tcb::sudoku::packed_corpus_magic);
+    REQUIRE(tcb::sudoku::read_packed_corpus(ss) == grids);
+
+    // A truncated file can't be read
+    std::stringstream truncated{ss.str().substr(0, ss.str().size() - 1)};
+    REQUIRE_FALSE(tcb::sudoku::read_packed_corpus(truncated));
+
+    // Nor can a text file
+    std::stringstream text{solvable};
+    REQUIRE_FALSE(tcb::sudoku::read_packed_corpus(text));
+
+    std::stringstream none;
+    tcb::sudoku::write_packed_corpus(none, {});
+    REQUIRE(tcb::sudoku::read_packed_corpus(none) == std::vector<tcb::sudoku::packed_grid>{});
+}
+
+TEST_CASE("Solved grids can be compressed", "[grid]")
+{
+    for (const auto* str : {solvable_soln, empty_soln}) {
+        const auto grid = *tcb::sudoku::grid::parse(str);
+        const auto compact = tcb::sudoku::compress_solution(grid);
+        REQUIRE(compact);
+        REQUIRE(compact->size <= 12);
+        REQUIRE(tcb::sudoku::decompress_solution(*compact) == grid);
+    }
+
+    // Only complete, valid solutions can be compressed
+    REQUIRE_FALSE(tcb::sudoku::compress_solution(*tcb::sudoku::grid::parse(solvable)));
+    auto str = std::string(solvable_soln);
+    std::swap(str[0], str[1]);
+    REQUIRE_FALSE(tcb::sudoku::compress_solution(*tcb::sudoku::grid::parse(str)));
+
+    // Not every string of bytes is a solution
+    tcb::sudoku::compact_solution junk;
+    junk.bytes.fill(0xff);
+    junk.size = junk.bytes.size();
+    REQUIRE_FALSE(tcb::sudoku::decompress_solution(junk));
+    junk.size = 14;
+    REQUIRE_FALSE(tcb::sudoku::decompress_solution(junk));
+}
+
 TEST_CASE("Grids can be default constructed", "[grid]")
 {
     const tcb::sudoku::grid g;
@@ -346,7 +489,7 @@ TEST_CASE("Solving empty grids works as expected", "[solve]")
     const auto grid = tcb::sudoku::grid{};
     const auto soln = tcb::sudoku::solve(grid);
     REQUIRE(soln);
-    REQUIRE(equal(empty_soln, *soln));
+    REQUIRE(solves(grid, *soln));
 }
 
 TEST_CASE("Unsolvable grids are handled correctly", "[solve]")
@@ -356,3 +499,518 @@ TEST_CASE("Unsolvable grids are handled correctly", "[solve]")
     const auto soln = tcb::sudoku::solve(*grid);
     REQUIRE_FALSE(soln);
 }
+
+TEST_CASE("Batch solving gives the same results as solving one at a time", "[solve]")
+{
+    // Use enough grids that we need more than one batch, whatever the
+    // batch size is
+    std::vector<tcb::sudoku::grid> grids;
+    for (int i = 0; i < 25; i++) {
+        grids.push_back(*tcb::sudoku::grid::parse(solvable));
+        grids.push_back(*tcb::sudoku::grid::parse(unsolvable));
+        grids.push_back(*tcb::sudoku::grid::parse(solvable_soln));
+        grids.push_back(tcb::sudoku::grid{});
+    }
+
+    const auto solns = tcb::sudoku::solve_batch(grids);
+    REQUIRE(solns.size() == grids.size());
+    for (std::size_t i = 0; i < grids.size(); i++) {
+        REQUIRE(solns[i] == tcb::sudoku::solve(grids[i]));
+    }
+}
+
+TEST_CASE("Batch solving an empty vector works", "[solve]")
+{
+    const auto solns = tcb::sudoku::solve_batch({});
+    REQUIRE(solns.empty());
+}
+
+/*
+ * Asynchronous solving tests
+ */
+
+TEST_CASE("Grids can be solved asynchronously using futures", "[async]")
+{
+    const auto grid = *tcb::sudoku::grid::parse(solvable);
+    auto future = tcb::sudoku::solve_async(grid);
+    const auto soln = future.get();
+    REQUIRE(soln);
+    REQUIRE(equal(solvable_soln, *soln));
+
+    const auto bad_grid = *tcb::sudoku::grid::parse(unsolvable);
+    REQUIRE_FALSE(tcb::sudoku::solve_async(bad_grid).get());
+}
+
+TEST_CASE("Asynchronous solves can use a user-supplied pool", "[async]")
+{
+    tcb::sudoku::worker_pool pool{2};
+    REQUIRE(pool.size() == 2);
+
+    std::vector<std::future<std::optional<tcb::sudoku::grid>>> futures;
+    for (int i = 0; i < 10; i++) {
+        futures.push_back(tcb::sudoku::solve_async(tcb::sudoku::grid{}, pool));
+    }
+    for (auto& f : futures) {
+        const auto soln = f.get();
+        REQUIRE(soln);
+        REQUIRE(solves(tcb::sudoku::grid{}, *soln));
+    }
+}
+
+TEST_CASE("Asynchronous solve callbacks are run from the completion queue", "[async]")
+{
+    tcb::sudoku::completion_queue queue;
+    const auto this_thread = std::this_thread::get_id();
+
+    int num_solved = 0;
+    int num_failed = 0;
+    auto callback = [&] (std::optional<tcb::sudoku::grid> soln) {
+        REQUIRE(std::this_thread::get_id() == this_thread);
+        if (soln) {
+            REQUIRE(equal(solvable_soln, *soln));
+            ++num_solved;
+        } else {
+            ++num_failed;
+        }
+    };
+
+    // Nothing has been submitted, so this should just return
+    REQUIRE(queue.poll() == 0);
+
+    for (int i = 0; i < 3; i++) {
+        tcb::sudoku::solve_async(*tcb::sudoku::grid::parse(solvable), queue, callback);
+    }
+    tcb::sudoku::solve_async(*tcb::sudoku::grid::parse(unsolvable), queue, callback);
+
+    std::size_t num_callbacks = 0;
+    while (num_callbacks < 4) {
+        num_callbacks += queue.wait();
+    }
+
+    REQUIRE(num_callbacks == 4);
+    REQUIRE(num_solved == 3);
+    REQUIRE(num_failed == 1);
+}
+
+TEST_CASE("All the solutions of a grid can be enumerated", "[solve]")
+{
+    const auto grid = *tcb::sudoku::grid::parse(two_solutions);
+
+    auto e = tcb::sudoku::solution_enumerator{grid};
+    const auto first = e.next();
+    const auto second = e.next();
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(*first != *second);
+    REQUIRE(first == tcb::sudoku::solve(grid));
+    REQUIRE_FALSE(e.next());
+    REQUIRE_FALSE(e.next());
+}
+
+TEST_CASE("Unsolvable grids have no solutions to enumerate", "[solve]")
+{
+    auto e = tcb::sudoku::solution_enumerator{*tcb::sudoku::grid::parse(unsolvable)};
+    REQUIRE_FALSE(e.next());
+}
+
+TEST_CASE("The NUMA topology can be discovered", "[async]")
+{
+    const auto nodes = tcb::sudoku::numa_topology();
+    REQUIRE_FALSE(nodes.empty());
+    for (const auto& node : nodes) {
+        REQUIRE_FALSE(node.cpus.empty());
+    }
+}
+
+TEST_CASE("Batch solving can use a pool of pinned threads", "[async]")
+{
+    const auto node = tcb::sudoku::numa_topology().front();
+    tcb::sudoku::worker_pool pool{node.cpus};
+    REQUIRE(pool.size() == node.cpus.size());
+
+    // Use enough (quick to solve) grids to be split between several threads
+    std::vector<tcb::sudoku::grid> grids;
+    for (int i = 0; i < 2000; i++) {
+        grids.push_back(*tcb::sudoku::grid::parse(i % 2 ? solvable_soln : unsolvable));
+    }
+    grids.push_back(*tcb::sudoku::grid::parse(solvable));
+
+    REQUIRE(tcb::sudoku::solve_batch(grids, pool) == tcb::sudoku::solve_batch(grids));
+    REQUIRE(tcb::sudoku::solve_batch({}, pool).empty());
+
+    REQUIRE_THROWS_AS((tcb::sudoku::worker_pool{std::vector<int>{}}), std::invalid_argument);
+}
+
+TEST_CASE("Solver objects can be reused", "[solve]")
+{
+    tcb::sudoku::solver s;
+
+    const auto soln1 = s.solve(*tcb::sudoku::grid::parse(solvable));
+    REQUIRE(soln1);
+    REQUIRE(equal(solvable_soln, *soln1));
+    // This one needs to guess (and backtrack) quite a bit
+    REQUIRE(s.stats().guesses > 0);
+    REQUIRE(s.stats().backtracks > 0);
+
+    REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable)));
+    REQUIRE(s.stats().guesses == 0);
+
+    // An already-solved grid needs no guesses at all
+    const auto soln2 = s.solve(*tcb::sudoku::grid::parse(solvable_soln));
+    REQUIRE(soln2);
+    REQUIRE(equal(solvable_soln, *soln2));
+    REQUIRE(s.stats().guesses == 0);
+    REQUIRE(s.stats().backtracks == 0);
+}
+
+TEST_CASE("Hard grids can be solved with speculative parallel search", "[solve]")
+{
+    tcb::sudoku::worker_pool pool{3};
+    tcb::sudoku::solve_options options;
+    options.pool = &pool;
+
+    for (int depth : {1, 2, 4}) {
+        options.parallel_depth = depth;
+
+        const auto soln = tcb::sudoku::solve(*tcb::sudoku::grid::parse(solvable), options);
+        REQUIRE(soln);
+        REQUIRE(equal(solvable_soln, *soln));
+
+        REQUIRE_FALSE(tcb::sudoku::solve(*tcb::sudoku::grid::parse(unsolvable), options));
+
+        const auto solved = tcb::sudoku::solve(*tcb::sudoku::grid::parse(solvable_soln), options);
+        REQUIRE(solved);
+        REQUIRE(equal(solvable_soln, *solved));
+    }
+}
+
+TEST_CASE("Parallel search works when called from the pool's only thread", "[solve]")
+{
+    tcb::sudoku::worker_pool pool{1};
+    tcb::sudoku::solve_options options;
+    options.parallel_depth = 3;
+    options.pool = &pool;
+
+    std::promise<std::optional<tcb::sudoku::grid>> promise;
+    pool.post([&] {
+        promise.set_value(tcb::sudoku::solve(*tcb::sudoku::grid::parse(solvable), options));
+    });
+    const auto soln = promise.get_future().get();
+    REQUIRE(soln);
+    REQUIRE(equal(solvable_soln, *soln));
+}
+
+TEST_CASE("Digits can be tried in descending order", "[solve]")
+{
+    tcb::sudoku::solve_options options;
+    options.values = tcb::sudoku::value_order::descending;
+
+    const auto soln = tcb::sudoku::solve(*tcb::sudoku::grid::parse(solvable), options);
+    REQUIRE(soln);
+    REQUIRE(equal(solvable_soln, *soln));
+    REQUIRE_FALSE(tcb::sudoku::solve(*tcb::sudoku::grid::parse(unsolvable), options));
+
+    // With two solutions, each order finds a different one first
+    const auto grid = *tcb::sudoku::grid::parse(two_solutions);
+    const auto first = tcb::sudoku::solve(grid);
+    const auto last = tcb::sudoku::solve(grid, options);
+    REQUIRE(first);
+    REQUIRE(last);
+    REQUIRE(*first != *last);
+}
+
+TEST_CASE("Portfolios of solvers can be raced against each other", "[solve]")
+{
+    REQUIRE(tcb::sudoku::default_portfolio(0).empty());
+    REQUIRE(tcb::sudoku::default_portfolio(1).size() == 1);
+
+    tcb::sudoku::worker_pool pool{2};
+    tcb::sudoku::solve_options options;
+    options.portfolio = tcb::sudoku::default_portfolio(4);
+    options.pool = &pool;
+    REQUIRE_FALSE(options.portfolio.empty());
+
+    const auto soln = tcb::sudoku::solve(*tcb::sudoku::grid::parse(solvable), options);
+    REQUIRE(soln);
+    REQUIRE(equal(solvable_soln, *soln));
+    REQUIRE_FALSE(tcb::sudoku::solve(*tcb::sudoku::grid::parse(unsolvable), options));
+}
+
+TEST_CASE("Random choices are reproducible from the seed", "[solve]")
+{
+    tcb::sudoku::solve_options options;
+    options.values = tcb::sudoku::value_order::random;
+    options.random_ties = true;
+
+    const auto grid = *tcb::sudoku::grid::parse(two_solutions);
+    auto s = tcb::sudoku::solver{};
+    bool found_second = false;
+
+    for (std::uint64_t seed = 0; seed < 20; seed++) {
+        options.seed = seed;
+        const auto soln = s.solve(grid, options);
+        const auto guesses = s.stats().guesses;
+        REQUIRE(soln);
+        REQUIRE(s.solve(grid, options) == soln);
+        REQUIRE(s.stats().guesses == guesses);
+        found_second = found_second || *soln != *tcb::sudoku::solve(grid);
+    }
+
+    // Some seed should have found the other solution first
+    REQUIRE(found_second);
+}
+
+TEST_CASE("Solvers can restart with growing limits", "[solve]")
+{
+    for (auto policy : {tcb::sudoku::restart_policy::luby,
+                        tcb::sudoku::restart_policy::geometric}) {
+        tcb::sudoku::solve_options options;
+        options.values = tcb::sudoku::value_order::random;
+        options.random_ties = true;
+        options.restarts = policy;
+        options.restart_base = 1;
+
+        auto s = tcb::sudoku::solver{};
+        const auto soln = s.solve(*tcb::sudoku::grid::parse(solvable), options);
+        REQUIRE(soln);
+        REQUIRE(equal(solvable_soln, *soln));
+        REQUIRE(s.stats().restarts > 0);
+
+        REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable), options));
+        REQUIRE(s.stats().restarts == 0);
+    }
+}
+
+TEST_CASE("Branching rules can be chosen at run time", "[solve]")
+{
+    using tcb::sudoku::branching_rule;
+    using tcb::sudoku::value_order;
+
+    for (auto rule : {branching_rule::mrv, branching_rule::mrv_degree, branching_rule::units}) {
+        for (auto order : {value_order::ascending, value_order::least_constraining}) {
+            tcb::sudoku::solve_options options;
+            options.branching = rule;
+            options.values = order;
+
+            auto s = tcb::sudoku::solver{};
+            const auto soln = s.solve(*tcb::sudoku::grid::parse(solvable), options);
+            REQUIRE(soln);
+            REQUIRE(equal(solvable_soln, *soln));
+            REQUIRE(s.stats().guesses > 0);
+
+            REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable), options));
+
+            const auto empty_grid = s.solve(*tcb::sudoku::grid::parse(empty), options);
+            REQUIRE(empty_grid);
+            REQUIRE(tcb::sudoku::solve(*empty_grid) == empty_grid);
+
+            auto e = tcb::sudoku::solution_enumerator{*tcb::sudoku::grid::parse(two_solutions)};
+            const auto first = e.next();
+            const auto second = e.next();
+            const auto found = s.solve(*tcb::sudoku::grid::parse(two_solutions), options);
+            REQUIRE(found);
+            REQUIRE((found == first || found == second));
+        }
+    }
+}
+
+TEST_CASE("Propagation levels can be chosen per call", "[solve]")
+{
+    using tcb::sudoku::propagation_level;
+
+    auto s = tcb::sudoku::solver{};
+    tcb::sudoku::solve_options options;
+
+    for (auto level : {propagation_level::singles, propagation_level::locked_candidates,
+                       propagation_level::subsets, propagation_level::x_wing}) {
+        options.propagation = level;
+
+        const auto soln = s.solve(*tcb::sudoku::grid::parse(solvable), options);
+        REQUIRE(soln);
+        REQUIRE(equal(solvable_soln, *soln));
+
+        REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable), options));
+
+        const auto grid = *tcb::sudoku::grid::parse(two_solutions);
+        auto e = tcb::sudoku::solution_enumerator{grid};
+        const auto first = e.next();
+        const auto second = e.next();
+        const auto found = s.solve(grid, options);
+        REQUIRE((found == first || found == second));
+    }
+}
+
+TEST_CASE("X-Wings can be found without guessing", "[solve]")
+{
+    // This puzzle can't be finished with singles, locked candidates and
+    // subsets alone, but needs an X-Wing on the 7s
+    const auto grid = *tcb::sudoku::grid::parse(
+        "1.....569492.561.8.561.924...964.8.1.64.1....218.356.4.4.5...169.5.614.2621.....5");
+    const auto expected = tcb::sudoku::solve(grid);
+    REQUIRE(expected);
+
+    auto s = tcb::sudoku::solver{};
+    tcb::sudoku::solve_options options;
+    options.propagation = tcb::sudoku::propagation_level::subsets;
+    REQUIRE(s.solve(grid, options) == expected);
+    REQUIRE(s.stats().guesses > 0);
+
+    options.propagation = tcb::sudoku::propagation_level::x_wing;
+    REQUIRE(s.solve(grid, options) == expected);
+    REQUIRE(s.stats().guesses == 0);
+}
+
+TEST_CASE("Backjumping finds the same solutions as backtracking", "[solve]")
+{
+    tcb::sudoku::solve_options options;
+    options.backjumping = true;
+    auto s = tcb::sudoku::solver{};
+
+    // Backjumping only skips parts of the tree with no solutions in, so with
+    // the default run-time MRV branching it finds the same first solution as
+    // solve(). A library built with another TCB_SUDOKU_BRANCHING rule can find
+    // a different one, so just check that it's a solution.
+    for (const auto& str : {solvable, empty, two_solutions}) {
+        const auto grid = *tcb::sudoku::grid::parse(str);
+        const auto soln = s.solve(grid, options);
+        REQUIRE(soln);
+        REQUIRE(solves(grid, *soln));
+    }
+
+    REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable), options));
+
+    // This one has no solution, but it takes some guessing to find out
+    const auto no_soln = *tcb::sudoku::grid::parse(
+        "4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4.....9");
+    REQUIRE_FALSE(s.solve(no_soln, options));
+    REQUIRE(s.stats().guesses > 0);
+}
+
+TEST_CASE("Grids can be solved with the SAT backend", "[solve]")
+{
+    tcb::sudoku::solve_options options;
+    options.backend = tcb::sudoku::solver_backend::sat;
+    auto s = tcb::sudoku::solver{};
+
+    const auto soln = s.solve(*tcb::sudoku::grid::parse(solvable), options);
+    REQUIRE(soln);
+    REQUIRE(equal(solvable_soln, *soln));
+    REQUIRE(s.stats().guesses > 0);
+
+    REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable), options));
+    const auto no_soln = *tcb::sudoku::grid::parse(
+        ".....5.8....6.1.43..........1.5........1.6...3.......553.....61........4.........");
+    REQUIRE_FALSE(s.solve(no_soln, options));
+    REQUIRE(s.stats().backtracks > 0);
+
+    // With lots of solutions, we might get any of them
+    const auto empty_grid = s.solve(*tcb::sudoku::grid::parse(empty), options);
+    REQUIRE(empty_grid);
+    REQUIRE(tcb::sudoku::solve(*empty_grid) == empty_grid);
+
+    // The same solver can be used again
+    REQUIRE(s.solve(*tcb::sudoku::grid::parse(solvable), options) == soln);
+    REQUIRE(tcb::sudoku::solve(*tcb::sudoku::grid::parse(solvable), options) == soln);
+}
+
+TEST_CASE("Solutions can be counted", "[solve]")
+{
+    using tcb::sudoku::count_solutions;
+    const auto two = *tcb::sudoku::grid::parse(two_solutions);
+
+    REQUIRE(count_solutions(*tcb::sudoku::grid::parse(solvable)) == 1);
+    REQUIRE(count_solutions(*tcb::sudoku::grid::parse(unsolvable)) == 0);
+    REQUIRE(count_solutions(two) == 2);
+    REQUIRE(count_solutions(two, 1) == 1);
+    REQUIRE(count_solutions(*tcb::sudoku::grid::parse(empty), 1000) == 1000);
+
+    tcb::sudoku::solve_options options;
+    options.transposition_table_size = 1 << 16;
+    auto s = tcb::sudoku::solver{};
+    REQUIRE(s.count_solutions(two, 10, options) == 2);
+    REQUIRE(s.count_solutions(*tcb::sudoku::grid::parse(unsolvable), 10, options) == 0);
+
+    // The second time around, the table already knows the answer
+    REQUIRE(s.count_solutions(two, 10, options) == 2);
+    REQUIRE(s.stats().table_hits > 0);
+    REQUIRE(s.stats().guesses == 0);
+}
+
+TEST_CASE("The transposition table doesn't change the solution", "[solve]")
+{
+    tcb::sudoku::solve_options options;
+    options.transposition_table_size = 1 << 16;
+    options.values = tcb::sudoku::value_order::random;
+    options.restarts = tcb::sudoku::restart_policy::luby;
+    options.restart_base = 1;
+    auto s = tcb::sudoku::solver{};
+
+    for (const auto* str : {solvable, two_solutions, empty}) {
+        const auto g = *tcb::sudoku::grid::parse(str);
+        REQUIRE(s.solve(g, options) == s.solve(g, [&] {
+            auto without = options;
+            without.transposition_table_size = 0;
+            return without;
+        }()));
+    }
+    REQUIRE_FALSE(s.solve(*tcb::sudoku::grid::parse(unsolvable), options));
+}
+
+TEST_CASE("Grid views can be created over buffers", "[grid]")
+{
+    // A buffer holding several puzzles, using '0' for unknown cells
+    auto puzzle = std::string(solvable);
+    std::replace(puzzle.begin(), puzzle.end(), '.', '0');
+    const auto buffer = "junk\n" + puzzle + "\n" + unsolvable + "\n";
+
+    const auto view = tcb::sudoku::grid_view::from(std::string_view(buffer).substr(5));
+    REQUIRE(view);
+    REQUIRE(view->data() == buffer.data() + 5);
+    REQUIRE((*view)[0] == '6');
+    REQUIRE((*view)[1] == '.');
+    REQUIRE(tcb::sudoku::solve(*view) == tcb::sudoku::grid::parse(solvable_soln));
+    REQUIRE(tcb::sudoku::validate(*view).empty());
+
+    const auto bad = tcb::sudoku::grid_view::from(std::string_view(buffer).substr(87));
+    REQUIRE(bad);
+    REQUIRE_FALSE(tcb::sudoku::solve(*bad));
+    REQUIRE(tcb::sudoku::validate(*bad).size() == 9);
+
+    // Views don't skip anything, and need all 81 cells
+    REQUIRE_FALSE(tcb::sudoku::grid_view::from(buffer));
+    REQUIRE_FALSE(tcb::sudoku::grid_view::from(std::string_view(buffer).substr(5, 80)));
+    REQUIRE_FALSE(tcb::sudoku::grid_view::from(std::string_view(buffer).substr(6)));
+
+    // Grids can be viewed too
+    const auto grid = *tcb::sudoku::grid::parse(solvable);
+    const tcb::sudoku::grid_view grid_view = grid;
+    REQUIRE(grid_view.data() == grid.data());
+    REQUIRE(tcb::sudoku::solve(grid_view) == tcb::sudoku::solve(grid));
+}
+
+TEST_CASE("Duplicate givens are reported by validate()", "[validate]")
+{
+    REQUIRE(tcb::sudoku::validate(*tcb::sudoku::grid::parse(solvable)).empty());
+    REQUIRE(tcb::sudoku::validate(*tcb::sudoku::grid::parse(empty)).empty());
+    REQUIRE(tcb::sudoku::validate(*tcb::sudoku::grid::parse(solvable_soln)).empty());
+
+    const auto row = tcb::sudoku::validate(*tcb::sudoku::grid::parse(unsolvable));
+    REQUIRE(row == (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8}));
+
+    // A clash in a box, and another in a column; the 7 is fine
+    auto str = std::string(81, '.');
+    str[0] = '5';
+    str[10] = '5';
+    str[2] = '3';
+    str[74] = '3';
+    str[40] = '7';
+    const auto g = *tcb::sudoku::grid::parse(str);
+    REQUIRE(tcb::sudoku::validate(g) == (std::vector<int>{0, 2, 10, 74}));
+    REQUIRE_FALSE(tcb::sudoku::solve(g));
+
+    // No duplicates doesn't mean there's a solution
+    const auto no_soln = *tcb::sudoku::grid::parse(
+        "12345678........9................................................................");
+    REQUIRE(tcb::sudoku::validate(no_soln).empty());
+    REQUIRE_FALSE(tcb::sudoku::solve(no_soln));
+}
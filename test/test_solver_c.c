@@ -14,6 +14,7 @@ int main(int argc, char **argv)
         int n_parsed = 0;
         FILE* stream = NULL;
         SudokuGrid *grid = NULL;
+        SudokuReader *reader = NULL;
 
         stream = fopen(file_path, "r");
         if (!stream) {
@@ -43,6 +44,22 @@ int main(int argc, char **argv)
             fprintf(stderr, "Error: could not parse all puzzles\n");
             return EXIT_FAILURE;
         }
+
+        /* A reader should find exactly the same puzzles */
+        rewind(stream);
+        reader = sudoku_reader_new(stream);
+        n_parsed = 0;
+        while ((grid = sudoku_reader_next(reader))) {
+            ++n_parsed;
+            sudoku_grid_free(grid);
+        }
+        sudoku_reader_free(reader);
+        fclose(stream);
+
+        if (n_parsed != num_puzzles) {
+            fprintf(stderr, "Error: reader could not parse all puzzles\n");
+            return EXIT_FAILURE;
+        }
     }
 
     return EXIT_SUCCESS;
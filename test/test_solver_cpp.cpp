@@ -3,6 +3,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 int main(int argc, char** argv)
 {
@@ -18,6 +19,8 @@ int main(int argc, char** argv)
 
         int n_parsed = 0;
         auto grid = std::optional<tcb::sudoku::grid>{};
+        std::vector<tcb::sudoku::grid> grids;
+        std::vector<std::optional<tcb::sudoku::grid>> solns;
         while ((grid = tcb::sudoku::grid::parse(is))) {
             ++n_parsed;
             const auto soln = tcb::sudoku::solve(*grid);
@@ -26,10 +29,133 @@ int main(int argc, char** argv)
                           << std::endl;
                 return 1;
             }
+            grids.push_back(*grid);
+            solns.push_back(soln);
         }
         if (n_parsed != num_puzzles) {
             std::cerr << "Error: could not read all puzzles\n";
             return 1;
         }
+
+        for (std::size_t j = 0; j < grids.size(); j++) {
+            const auto compact = tcb::sudoku::compress_solution(*solns[j]);
+            if (tcb::sudoku::grid::unpack(grids[j].pack()) != grids[j] ||
+                tcb::sudoku::grid::unpack(solns[j]->pack()) != solns[j] ||
+                !compact || tcb::sudoku::decompress_solution(*compact) != solns[j]) {
+                std::cerr << "Error: packed grid does not match\n"
+                          << grids[j] << std::endl;
+                return 1;
+            }
+        }
+
+        if (tcb::sudoku::solve_batch(grids) != solns) {
+            std::cerr << "Error: batch solutions do not match\n";
+            return 1;
+        }
+
+        tcb::sudoku::worker_pool pool{4};
+        if (tcb::sudoku::solve_batch(grids, pool) != solns) {
+            std::cerr << "Error: parallel batch solutions do not match\n";
+            return 1;
+        }
+
+        tcb::sudoku::solve_options options;
+        options.parallel_depth = 2;
+        options.pool = &pool;
+        for (std::size_t j = 0; j < grids.size(); j++) {
+            if (tcb::sudoku::solve(grids[j], options) != solns[j]) {
+                std::cerr << "Error: parallel search solution does not match\n"
+                          << grids[j] << std::endl;
+                return 1;
+            }
+        }
+
+        // Stronger propagation changes how the search goes (and so how many
+        // guesses it needs), but not the solutions
+        for (auto level : {tcb::sudoku::propagation_level::singles,
+                           tcb::sudoku::propagation_level::locked_candidates,
+                           tcb::sudoku::propagation_level::subsets,
+                           tcb::sudoku::propagation_level::x_wing}) {
+            tcb::sudoku::solver solver;
+            tcb::sudoku::solve_options options;
+            options.propagation = level;
+            for (std::size_t j = 0; j < grids.size(); j++) {
+                if (solver.solve(grids[j], options) != solns[j]) {
+                    std::cerr << "Error: propagation level solution does not match\n"
+                              << grids[j] << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        tcb::sudoku::solve_options sat;
+        sat.backend = tcb::sudoku::solver_backend::sat;
+        for (std::size_t j = 0; j < grids.size(); j++) {
+            if (tcb::sudoku::solve(grids[j], sat) != solns[j]) {
+                std::cerr << "Error: SAT solution does not match\n"
+                          << grids[j] << std::endl;
+                return 1;
+            }
+        }
+
+        tcb::sudoku::solve_options backjumping;
+        backjumping.backjumping = true;
+        for (std::size_t j = 0; j < grids.size(); j++) {
+            if (tcb::sudoku::solve(grids[j], backjumping) != solns[j]) {
+                std::cerr << "Error: backjumping solution does not match\n"
+                          << grids[j] << std::endl;
+                return 1;
+            }
+        }
+
+        for (auto rule : {tcb::sudoku::branching_rule::mrv_degree,
+                          tcb::sudoku::branching_rule::units}) {
+            tcb::sudoku::solve_options options;
+            options.branching = rule;
+            options.values = tcb::sudoku::value_order::least_constraining;
+            for (std::size_t j = 0; j < grids.size(); j++) {
+                if (tcb::sudoku::solve(grids[j], options) != solns[j]) {
+                    std::cerr << "Error: branching rule solution does not match\n"
+                              << grids[j] << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        tcb::sudoku::solve_options random;
+        random.values = tcb::sudoku::value_order::random;
+        random.random_ties = true;
+        random.restarts = tcb::sudoku::restart_policy::luby;
+        random.restart_base = 10;
+        for (std::size_t j = 0; j < grids.size(); j++) {
+            random.seed = j;
+            if (tcb::sudoku::solve(grids[j], random) != solns[j]) {
+                std::cerr << "Error: randomised solution does not match\n"
+                          << grids[j] << std::endl;
+                return 1;
+            }
+        }
+
+        tcb::sudoku::solve_options table;
+        table.transposition_table_size = 1 << 16;
+        tcb::sudoku::solver counter;
+        for (const auto& g : grids) {
+            if (counter.count_solutions(g, 2, table) != 1) {
+                std::cerr << "Error: puzzle does not have a unique solution\n"
+                          << g << std::endl;
+                return 1;
+            }
+        }
+
+        tcb::sudoku::solve_options portfolio;
+        portfolio.portfolio = tcb::sudoku::default_portfolio(4);
+        portfolio.pool = &pool;
+        for (std::size_t j = 0; j < grids.size(); j++) {
+            if (tcb::sudoku::solve(grids[j], portfolio) != solns[j]) {
+                std::cerr << "Error: portfolio solution does not match\n"
+                          << grids[j] << std::endl;
+                return 1;
+            }
+        }
     }
 }
\ No newline at end of file
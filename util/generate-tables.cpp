@@ -146,13 +146,26 @@ auto get_peers(int i)
     return output;
 }
 
+// Units are numbered rows first, then columns, then boxes
+auto get_unit(int u)
+{
+    if (u < 9) {
+        return get_row(9 * u);
+    }
+    if (u < 18) {
+        return get_column(u - 9);
+    }
+    const int b = u - 18;
+    return get_box(27 * (b/3) + 3 * (b % 3));
+}
+
 template <class Func>
-void print_table(Func f, int size, const char* name)
+void print_table(Func f, int size, const char* name, int count = 81)
 {
-    std::cout << "constexpr std::array<std::array<int, " << size << ">, 81> "
-              << name << "_indices = {{\n";
+    std::cout << "constexpr std::array<std::array<int, " << size << ">, "
+              << count << "> " << name << "_indices = {{\n";
 
-    for (int i = 0; i < 81; i++) {
+    for (int i = 0; i < count; i++) {
         std::cout << "    {{ ";
         const auto r = f(i);
         std::copy(begin(r), end(r), make_ostream_joiner(std::cout, ", "));
@@ -170,6 +183,7 @@ int main()
     print_table(get_column, 9, "column");
     print_table(get_box, 9, "box");
     print_table(get_peers, 20, "peers");
+    print_table(get_unit, 9, "unit", 27);
 
     std::cout << postamble;
 }